@@ -0,0 +1,582 @@
+/*----------------------------------------------------------------------------------
+Async file I/O awaitables on io_uring
+The coroutines in Coroutines.cpp name I/O as the use case but only sleep_for. Here
+a coroutine really waits for the disk without holding a thread:
+    co_await io.read_at(fd, buffer, length, offset)    returns the bytes read
+    co_await io.write_at(fd, buffer, length, offset)   returns the bytes written
+    co_await io.fsync(fd)
+    co_await io.read_fixed(fd, bufferIndex, length, offset) / write_fixed(...)
+        the same on a buffer registered with io.register_buffers(), which the
+        kernel pins and maps once instead of on every request
+Errors come back as std::system_error from the co_await. aio::IoContext is an event
+loop in the style of EventLoopCoroutines.cpp (spawn tasks, run() until they finish)
+with two backends:
+    - io_uring, through the raw syscalls (liburing is not required): an awaiter
+      only fills a submission queue entry; when the loop runs out of ready
+      coroutines it submits everything queued so far and waits for completions
+      in one io_uring_enter, so N coroutines issuing reads cost one syscall
+    - a fallback when io_uring is unavailable (old kernel, or blocked by seccomp
+      in many containers): a thread pool runs pread/pwrite/fsync and reports
+      completions through an eventfd that the loop waits on with epoll (regular
+      files are always "ready" for epoll, so the blocking calls need threads)
+Either way the coroutines resume on the loop thread.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <coroutine>
+#include <deque>
+#include <vector>
+#include <span>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <system_error>
+#include <exception>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace aio {
+
+class IoContext;
+
+enum class Op : std::uint8_t { Read, Write, Fsync };
+
+// The awaiter is the in-flight request: it lives in the suspended coroutine's frame
+struct IoOp {
+    IoContext* io;
+    Op op;
+    int fd;
+    void* buffer;
+    unsigned length;
+    off_t offset;
+    int bufferIndex;   // registered buffer, or -1
+    int result = 0;
+    std::coroutine_handle<> handle{};
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> awaiting);
+    int await_resume() const {
+        if (result < 0) {
+            throw std::system_error(-result, std::generic_category(),
+                                    op == Op::Read ? "read_at" : op == Op::Write ? "write_at" : "fsync");
+        }
+        return result;
+    }
+};
+
+class Backend {
+    public:
+        virtual ~Backend() = default;
+        virtual const char* name() const = 0;
+        virtual void start(IoOp& op) = 0;
+        // Blocks until at least one started operation completes and appends the
+        // coroutines to resume
+        virtual void wait(std::deque<std::coroutine_handle<>>& ready) = 0;
+        virtual void registerBuffers(std::span<const iovec>) {}
+        std::uint64_t waits() const { return m_waits; }
+    protected:
+        std::uint64_t m_waits = 0;   // blocking syscalls made by the loop
+};
+
+class UringBackend final : public Backend {
+    public:
+        // Throws std::system_error if the kernel refuses io_uring
+        explicit UringBackend(unsigned entries) {
+            io_uring_params params{};
+            m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (m_fd < 0) throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+            m_entries = params.sq_entries;
+            m_sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            m_singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (m_singleMmap) m_sqRingBytes = m_cqRingBytes = std::max(m_sqRingBytes, m_cqRingBytes);
+            m_sqRing = map(m_sqRingBytes, IORING_OFF_SQ_RING);
+            m_cqRing = m_singleMmap ? m_sqRing : map(m_cqRingBytes, IORING_OFF_CQ_RING);
+            m_sqes = static_cast<io_uring_sqe*>(map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+            auto* sq = static_cast<char*>(m_sqRing);
+            auto* cq = static_cast<char*>(m_cqRing);
+            m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        }
+        ~UringBackend() override {
+            munmap(m_sqes, m_entries * sizeof(io_uring_sqe));
+            if (!m_singleMmap) munmap(m_cqRing, m_cqRingBytes);
+            munmap(m_sqRing, m_sqRingBytes);
+            close(m_fd);
+        }
+        const char* name() const override { return "io_uring"; }
+
+        void start(IoOp& op) override {
+            // Never more requests outstanding than SQ entries, so the CQ (twice
+            // as large) cannot overflow
+            if (m_outstanding == m_entries) {
+                m_backlog.push_back(&op);
+                return;
+            }
+            queue(op);
+        }
+        void wait(std::deque<std::coroutine_handle<>>& ready) override {
+            int rc;
+            do {
+                rc = static_cast<int>(syscall(__NR_io_uring_enter, m_fd, m_unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+            } while (rc < 0 && errno == EINTR);
+            if (rc < 0) throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+            ++m_waits;
+            m_unsubmitted -= static_cast<unsigned>(rc);
+            reap(ready);
+            while (!m_backlog.empty() && m_outstanding < m_entries) {
+                queue(*m_backlog.front());
+                m_backlog.pop_front();
+            }
+        }
+        void registerBuffers(std::span<const iovec> buffers) override {
+            if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, buffers.data(), buffers.size()) < 0) {
+                throw std::system_error(errno, std::generic_category(), "io_uring_register");
+            }
+        }
+    private:
+        void* map(std::size_t bytes, off_t offset) {
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+            if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap io_uring");
+            return p;
+        }
+        void queue(IoOp& op) {
+            const unsigned tail = *m_sqTail;
+            const unsigned index = tail & m_sqMask;
+            io_uring_sqe& sqe = m_sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.fd = op.fd;
+            sqe.user_data = reinterpret_cast<std::uint64_t>(&op);
+            switch (op.op) {
+                case Op::Read:
+                    sqe.opcode = op.bufferIndex >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READ;
+                    break;
+                case Op::Write:
+                    sqe.opcode = op.bufferIndex >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+                    break;
+                case Op::Fsync:
+                    sqe.opcode = IORING_OP_FSYNC;
+                    break;
+            }
+            if (op.op != Op::Fsync) {
+                sqe.addr = reinterpret_cast<std::uint64_t>(op.buffer);
+                sqe.len = op.length;
+                sqe.off = static_cast<std::uint64_t>(op.offset);
+                if (op.bufferIndex >= 0) sqe.buf_index = static_cast<std::uint16_t>(op.bufferIndex);
+            }
+            m_sqArray[index] = index;
+            __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+            ++m_unsubmitted;
+            ++m_outstanding;
+        }
+        void reap(std::deque<std::coroutine_handle<>>& ready) {
+            unsigned head = *m_cqHead;
+            const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                auto* op = reinterpret_cast<IoOp*>(cqe.user_data);
+                op->result = cqe.res;
+                ready.push_back(op->handle);
+                --m_outstanding;
+            }
+            __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        }
+
+        int m_fd = -1;
+        unsigned m_entries = 0;
+        std::size_t m_sqRingBytes = 0, m_cqRingBytes = 0;
+        bool m_singleMmap = false;
+        void* m_sqRing = nullptr;
+        void* m_cqRing = nullptr;
+        io_uring_sqe* m_sqes = nullptr;
+        unsigned *m_sqHead = nullptr, *m_sqTail = nullptr, *m_sqArray = nullptr;
+        unsigned *m_cqHead = nullptr, *m_cqTail = nullptr;
+        unsigned m_sqMask = 0, m_cqMask = 0;
+        io_uring_cqe* m_cqes = nullptr;
+        unsigned m_unsubmitted = 0, m_outstanding = 0;
+        std::deque<IoOp*> m_backlog;
+};
+
+class ThreadPoolBackend final : public Backend {
+    public:
+        explicit ThreadPoolBackend(unsigned threads) {
+            m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+            if (m_eventFd < 0 || m_epollFd < 0) throw std::system_error(errno, std::generic_category(), "eventfd/epoll");
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = m_eventFd;
+            epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_eventFd, &event);
+            for (unsigned i = 0; i < threads; ++i) {
+                m_workers.emplace_back([this](std::stop_token stop) { workerLoop(stop); });
+            }
+        }
+        ~ThreadPoolBackend() override {
+            for (auto& worker : m_workers) worker.request_stop();
+            m_cv.notify_all();
+            m_workers.clear();
+            close(m_epollFd);
+            close(m_eventFd);
+        }
+        const char* name() const override { return "thread pool + epoll"; }
+
+        void start(IoOp& op) override {
+            {
+                std::lock_guard lock(m_mutex);
+                m_queue.push_back(&op);
+            }
+            m_cv.notify_one();
+        }
+        void wait(std::deque<std::coroutine_handle<>>& ready) override {
+            std::vector<IoOp*> done;
+            while (done.empty()) {
+                epoll_event event;
+                if (epoll_wait(m_epollFd, &event, 1, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    throw std::system_error(errno, std::generic_category(), "epoll_wait");
+                }
+                ++m_waits;
+                // Non-blocking: EAGAIN only means the count was already consumed
+                std::uint64_t count;
+                if (read(m_eventFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                    throw std::system_error(errno, std::generic_category(), "read eventfd");
+                }
+                std::lock_guard lock(m_mutex);
+                done.swap(m_done);
+            }
+            for (auto* op : done) ready.push_back(op->handle);
+        }
+    private:
+        void workerLoop(std::stop_token stop) {
+            while (true) {
+                IoOp* op;
+                {
+                    std::unique_lock lock(m_mutex);
+                    if (!m_cv.wait(lock, stop, [this] { return !m_queue.empty(); })) return;
+                    op = m_queue.front();
+                    m_queue.pop_front();
+                }
+                ssize_t rc = 0;
+                switch (op->op) {
+                    case Op::Read: rc = pread(op->fd, op->buffer, op->length, op->offset); break;
+                    case Op::Write: rc = pwrite(op->fd, op->buffer, op->length, op->offset); break;
+                    case Op::Fsync: rc = ::fsync(op->fd); break;
+                }
+                op->result = rc < 0 ? -errno : static_cast<int>(rc);
+                {
+                    std::lock_guard lock(m_mutex);
+                    m_done.push_back(op);
+                }
+                const std::uint64_t one = 1;
+                [[maybe_unused]] auto written = write(m_eventFd, &one, sizeof(one));
+            }
+        }
+
+        int m_eventFd = -1, m_epollFd = -1;
+        std::mutex m_mutex;
+        std::condition_variable_any m_cv;
+        std::deque<IoOp*> m_queue;
+        std::vector<IoOp*> m_done;
+        std::vector<std::jthread> m_workers;   // last: joined before the rest goes away
+};
+
+// Fire-and-forget coroutine run by an IoContext
+class Task {
+    public:
+        struct promise_type {
+            IoContext* io = nullptr;
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            struct Final {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+                void await_resume() const noexcept {}
+            };
+            Final final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception();
+        };
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task& operator=(Task&&) = delete;
+        ~Task() { if (m_handle) m_handle.destroy(); }
+    private:
+        friend class IoContext;
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+        std::coroutine_handle<promise_type> m_handle;
+};
+
+class IoContext {
+    public:
+        enum class Mode { Auto, Uring, ThreadPool };
+
+        explicit IoContext(Mode mode = Mode::Auto, unsigned entries = 256, unsigned fallbackThreads = 8) {
+            if (mode != Mode::ThreadPool) {
+                try {
+                    m_backend = std::make_unique<UringBackend>(entries);
+                } catch (const std::system_error&) {
+                    if (mode == Mode::Uring) throw;
+                }
+            }
+            if (!m_backend) m_backend = std::make_unique<ThreadPoolBackend>(fallbackThreads);
+        }
+        IoContext(const IoContext&) = delete;
+        IoContext& operator=(const IoContext&) = delete;
+
+        const char* backend() const { return m_backend->name(); }
+        std::uint64_t waits() const { return m_backend->waits(); }
+
+        void spawn(Task task) {
+            auto handle = std::exchange(task.m_handle, nullptr);
+            handle.promise().io = this;
+            ++m_live;
+            m_ready.push_back(handle);
+        }
+        void run() {
+            while (m_live > 0) {
+                while (!m_ready.empty()) {
+                    auto handle = m_ready.front();
+                    m_ready.pop_front();
+                    handle.resume();
+                }
+                if (m_error) std::rethrow_exception(std::exchange(m_error, nullptr));
+                if (m_live > 0) m_backend->wait(m_ready);
+            }
+        }
+
+        // Buffers stay registered for the lifetime of the context
+        void register_buffers(std::vector<iovec> buffers) {
+            m_buffers = std::move(buffers);
+            m_backend->registerBuffers(m_buffers);
+        }
+
+        IoOp read_at(int fd, void* buffer, unsigned length, off_t offset) {
+            return {this, Op::Read, fd, buffer, length, offset, -1};
+        }
+        IoOp write_at(int fd, const void* buffer, unsigned length, off_t offset) {
+            return {this, Op::Write, fd, const_cast<void*>(buffer), length, offset, -1};
+        }
+        IoOp fsync(int fd) { return {this, Op::Fsync, fd, nullptr, 0, 0, -1}; }
+        IoOp read_fixed(int fd, int bufferIndex, unsigned length, off_t offset) {
+            return {this, Op::Read, fd, m_buffers.at(bufferIndex).iov_base, length, offset, bufferIndex};
+        }
+        IoOp write_fixed(int fd, int bufferIndex, unsigned length, off_t offset) {
+            return {this, Op::Write, fd, m_buffers.at(bufferIndex).iov_base, length, offset, bufferIndex};
+        }
+    private:
+        friend struct IoOp;
+        friend struct Task::promise_type;
+
+        std::unique_ptr<Backend> m_backend;
+        std::vector<iovec> m_buffers;
+        std::deque<std::coroutine_handle<>> m_ready;
+        std::size_t m_live = 0;
+        std::exception_ptr m_error;
+};
+
+inline void IoOp::await_suspend(std::coroutine_handle<> awaiting) {
+    handle = awaiting;
+    io->m_backend->start(*this);
+}
+inline void Task::promise_type::Final::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    auto* io = handle.promise().io;
+    handle.destroy();
+    --io->m_live;
+}
+inline void Task::promise_type::unhandled_exception() {
+    if (!io->m_error) io->m_error = std::current_exception();
+}
+
+}   // namespace aio
+
+aio::Task save_and_load(aio::IoContext& io, int fd) {
+    const std::string message = "written by a coroutine, read back by a coroutine";
+    const int written = co_await io.write_at(fd, message.data(), static_cast<unsigned>(message.size()), 0);
+    co_await io.fsync(fd);
+    std::string back(message.size(), '\0');
+    const int read = co_await io.read_at(fd, back.data(), static_cast<unsigned>(back.size()), 0);
+    std::cout << "  wrote " << written << " bytes, fsync done, read " << read << ": \"" << back << "\"" << std::endl;
+    try {
+        co_await io.read_at(-1, back.data(), 1, 0);
+    } catch (const std::system_error& e) {
+        std::cout << "  " << e.what() << std::endl;
+    }
+}
+
+constexpr unsigned BlockSize = 4096;
+
+struct Buffer {
+    explicit Buffer(std::size_t bytes) : data(static_cast<char*>(std::aligned_alloc(BlockSize, bytes))) {}
+    ~Buffer() { std::free(data); }
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+    char* data;
+};
+
+// One of 'depth' coroutines; together they keep 'depth' reads in flight
+aio::Task random_reader(aio::IoContext& io, int fd, char* buffer, int bufferIndex, std::uint64_t blocks,
+                        int reads, unsigned seed, std::uint64_t& checksum) {
+    std::mt19937_64 rng(seed);
+    for (int i = 0; i < reads; ++i) {
+        const off_t offset = static_cast<off_t>(rng() % blocks) * BlockSize;
+        const int n = bufferIndex >= 0 ? co_await io.read_fixed(fd, bufferIndex, BlockSize, offset)
+                                       : co_await io.read_at(fd, buffer, BlockSize, offset);
+        if (n > 0) checksum += static_cast<unsigned char>(buffer[n - 1]);
+    }
+}
+
+struct Result {
+    double iops;
+    double waitsPerRead;
+};
+
+Result coroutineReads(aio::IoContext::Mode mode, bool fixed, int fd, std::uint64_t blocks, int depth, int reads) {
+    aio::IoContext io(mode, static_cast<unsigned>(depth), static_cast<unsigned>(depth));
+    Buffer buffers(static_cast<std::size_t>(depth) * BlockSize);
+    if (fixed) {
+        std::vector<iovec> registered(depth);
+        for (int i = 0; i < depth; ++i) registered[i] = {buffers.data + i * BlockSize, BlockSize};
+        io.register_buffers(std::move(registered));
+    }
+    std::uint64_t checksum = 0;
+    for (int i = 0; i < depth; ++i) {
+        io.spawn(random_reader(io, fd, buffers.data + i * BlockSize, fixed ? i : -1, blocks, reads / depth, 1234 + i, checksum));
+    }
+    const auto start = std::chrono::steady_clock::now();
+    io.run();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {reads / seconds, static_cast<double>(io.waits()) / reads};
+}
+
+// Blocking pread on 'threads' threads, each pulling its next read from a counter
+double preadReads(int fd, std::uint64_t blocks, int threads, int reads) {
+    std::atomic<int> next{0};
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&next, fd, blocks, reads, t] {
+                Buffer buffer(BlockSize);
+                std::mt19937_64 rng(99 + t);
+                while (next.fetch_add(1, std::memory_order_relaxed) < reads) {
+                    const off_t offset = static_cast<off_t>(rng() % blocks) * BlockSize;
+                    if (pread(fd, buffer.data, BlockSize, offset) != BlockSize) std::abort();
+                }
+            });
+        }
+    }
+    return reads / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    const char* demoPath = "async_file_io_demo.txt";
+    for (auto mode : {aio::IoContext::Mode::Auto, aio::IoContext::Mode::ThreadPool}) {
+        aio::IoContext io(mode);
+        std::cout << "backend: " << io.backend() << std::endl;
+        const int fd = open(demoPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cout << "cannot create " << demoPath << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        io.spawn(save_and_load(io, fd));
+        io.run();
+        close(fd);
+    }
+    unlink(demoPath);
+
+    // Random 4 KiB reads with O_DIRECT, so they reach the device, not the page cache
+    const char* path = "async_file_io_bench.dat";
+    constexpr std::uint64_t fileBytes = 512ull << 20;
+    constexpr std::uint64_t blocks = fileBytes / BlockSize;
+    {
+        const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cout << "cannot create " << path << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        std::vector<char> chunk(1 << 20);
+        std::mt19937 rng(7);
+        for (auto& c : chunk) c = static_cast<char>(rng());
+        for (std::uint64_t written = 0; written < fileBytes; written += chunk.size()) {
+            if (write(fd, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) std::abort();
+        }
+        ::fsync(fd);
+        close(fd);
+    }
+    const int fd = open(path, O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if (fd < 0) {
+        std::cout << "O_DIRECT not supported here: " << std::strerror(errno) << std::endl;
+        unlink(path);
+        return 0;
+    }
+    constexpr int reads = 40'000;
+    std::cout << "random 4 KiB O_DIRECT reads from a 512 MiB file, " << reads << " per run" << std::endl;
+    std::cout << "approach | in flight | IOPS | blocking waits per read" << std::endl;
+    std::cout << "pread, 1 thread | 1 | " << preadReads(fd, blocks, 1, reads) << " | 1" << std::endl;
+    for (int depth : {8, 32, 128}) {
+        std::cout << "pread, thread pool | " << depth << " | " << preadReads(fd, blocks, depth, reads) << " | 1" << std::endl;
+        const auto pool = coroutineReads(aio::IoContext::Mode::ThreadPool, false, fd, blocks, depth, reads);
+        std::cout << "coroutines, thread pool + epoll | " << depth << " | " << pool.iops << " | " << pool.waitsPerRead << std::endl;
+        try {
+            const auto uring = coroutineReads(aio::IoContext::Mode::Uring, false, fd, blocks, depth, reads);
+            std::cout << "coroutines, io_uring | " << depth << " | " << uring.iops << " | " << uring.waitsPerRead << std::endl;
+            const auto fixed = coroutineReads(aio::IoContext::Mode::Uring, true, fd, blocks, depth, reads);
+            std::cout << "coroutines, io_uring fixed buffers | " << depth << " | " << fixed.iops << " | " << fixed.waitsPerRead << std::endl;
+        } catch (const std::system_error& e) {
+            std::cout << "io_uring unavailable: " << e.what() << std::endl;
+        }
+    }
+    close(fd);
+    unlink(path);
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+backend: io_uring
+  wrote 48 bytes, fsync done, read 48: "written by a coroutine, read back by a coroutine"
+  read_at: Bad file descriptor
+backend: thread pool + epoll
+  wrote 48 bytes, fsync done, read 48: "written by a coroutine, read back by a coroutine"
+  read_at: Bad file descriptor
+random 4 KiB O_DIRECT reads from a 512 MiB file, 40000 per run
+approach | in flight | IOPS | blocking waits per read
+pread, 1 thread | 1 | 42272.1 | 1
+pread, thread pool | 8 | 127742 | 1
+coroutines, thread pool + epoll | 8 | 75025.7 | 0.2064
+coroutines, io_uring | 8 | 109807 | 0.125
+coroutines, io_uring fixed buffers | 8 | 111999 | 0.125
+pread, thread pool | 32 | 142482 | 1
+coroutines, thread pool + epoll | 32 | 75423.4 | 0.071175
+coroutines, io_uring | 32 | 137814 | 0.03125
+coroutines, io_uring fixed buffers | 32 | 145526 | 0.03125
+pread, thread pool | 128 | 139898 | 1
+coroutines, thread pool + epoll | 128 | 58966.1 | 0.01215
+coroutines, io_uring | 128 | 202307 | 0.011825
+coroutines, io_uring fixed buffers | 128 | 218947 | 0.011825
+The disk is a virtio block device. The pread pool needs one thread per request in
+flight and stops improving past 32 threads: on one core they mostly
+context-switch. io_uring keeps 128 reads in flight from a single thread with about
+one io_uring_enter per 85 reads, and registered buffers add a further 5-8%. The
+coroutine fallback pays for a queue handoff and an eventfd wake per read, so it is
+the slowest way to get parallelism and is only there for kernels without io_uring.
+-------------------------------------------------------------*/
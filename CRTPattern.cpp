@@ -3,9 +3,29 @@ CRTP: Curiously Recurring Template Pattern
 It involves a class template inheriting from another class template that takes
 the derived class as a template parameter. This allows static polymorphism which
 can be used to implement compile time polymorphishm
+The same trick is used to build small reusable mixins. Each mixin takes the final
+type as a parameter and adds one capability to it, with no vtable and no indirect
+call; the compiler sees the exact function and can inline it:
+    - InstanceCounter<D> - live/total object counters per type
+    - Comparable<D>      - ==, !=, <, <=, >, >= derived from a single key()
+    - Cloneable<D, B>    - clone() returning std::unique_ptr<B>
+    - Visitable<D>       - accept(visitor) calling visitor(D&) with the static type
+They compose through variadic inheritance: class Point : public WithMixins<Point, ...>
 /-------------------------------------------------------------------------------*/
 
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <variant>
+#include <functional>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 template<typename Derived>
 class Base {
@@ -22,9 +42,255 @@ class Derived : public Base<Derived> {
             // Implementation of the method
         }
 };
+
+// Counts live and ever-created objects of Derived. Each Derived gets its own
+// counters because InstanceCounter<A> and InstanceCounter<B> are different types
+template<typename Derived>
+class InstanceCounter {
+    public:
+        static std::size_t live() { return s_live; }
+        static std::size_t created() { return s_created; }
+    protected:
+        InstanceCounter() { ++s_live; ++s_created; }
+        InstanceCounter(const InstanceCounter&) { ++s_live; ++s_created; }
+        InstanceCounter& operator=(const InstanceCounter&) = default;
+        ~InstanceCounter() { --s_live; }
+    private:
+        inline static std::size_t s_live = 0;
+        inline static std::size_t s_created = 0;
+};
+
+// Derived only has to provide key(); all comparison operators follow from it
+template<typename Derived>
+class Comparable {
+    public:
+        friend bool operator==(const Derived& a, const Derived& b) { return a.key() == b.key(); }
+        friend bool operator!=(const Derived& a, const Derived& b) { return !(a == b); }
+        friend bool operator<(const Derived& a, const Derived& b) { return a.key() < b.key(); }
+        friend bool operator>(const Derived& a, const Derived& b) { return b < a; }
+        friend bool operator<=(const Derived& a, const Derived& b) { return !(b < a); }
+        friend bool operator>=(const Derived& a, const Derived& b) { return !(a < b); }
+};
+
+// Implements the virtual clone() of an interface once for every Derived
+template<typename Derived, typename Interface>
+class Cloneable : public Interface {
+    public:
+        std::unique_ptr<Interface> clone() const override {
+            return std::make_unique<Derived>(static_cast<const Derived&>(*this));
+        }
+};
+
+// Double dispatch without virtual functions: the visitor gets the static type
+template<typename Derived>
+class Visitable {
+    public:
+        template<typename Visitor>
+        decltype(auto) accept(Visitor&& visitor) {
+            return std::forward<Visitor>(visitor)(static_cast<Derived&>(*this));
+        }
+};
+
+// Combines any number of mixins onto one type
+template<typename Derived, template<typename> class... Mixins>
+class WithMixins : public Mixins<Derived>... {};
+
+class IShape {
+    public:
+        virtual ~IShape() = default;
+    public:
+        virtual std::unique_ptr<IShape> clone() const = 0;
+        virtual double area() const = 0;
+};
+
+class Point : public WithMixins<Point, InstanceCounter, Comparable, Visitable> {
+    public:
+        Point(int x, int y) : m_x(x), m_y(y) {}
+        long key() const { return static_cast<long>(m_x) * 100000 + m_y; }
+        int x() const { return m_x; }
+        int y() const { return m_y; }
+    private:
+        int m_x;
+        int m_y;
+};
+
+class Square : public Cloneable<Square, IShape>, public InstanceCounter<Square> {
+    public:
+        explicit Square(double side) : m_side(side) {}
+        double area() const override { return m_side * m_side; }
+    private:
+        double m_side;
+};
+
+/*------------------------- Dispatch-cost benchmark ----------------------------*/
+// Two shapes with a cheap operation, expressed four ways
+
+struct VShape { virtual ~VShape() = default; virtual double area() const = 0; };
+struct VCircle final : VShape { double r; explicit VCircle(double v) : r(v) {} double area() const override { return 3.0 * r * r; } };
+struct VRect final : VShape { double w; explicit VRect(double v) : w(v) {} double area() const override { return w * 2.0; } };
+
+template<typename D>
+struct SBase { double area() const { return static_cast<const D*>(this)->areaImpl(); } };
+struct SCircle : SBase<SCircle> { double r; double areaImpl() const { return 3.0 * r * r; } };
+struct SRect : SBase<SRect> { double w; double areaImpl() const { return w * 2.0; } };
+
+struct PCircle { double r; double area() const { return 3.0 * r * r; } };
+struct PRect { double w; double area() const { return w * 2.0; } };
+
+// Thin wrapper around perf_event_open; counters are reported as n/a when the
+// kernel or the container does not allow them (perf_event_paranoid, seccomp)
+class PerfCounter {
+    public:
+        PerfCounter(std::uint32_t type, std::uint64_t config) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        ~PerfCounter() { if (m_fd >= 0) close(m_fd); }
+        PerfCounter(const PerfCounter&) = delete;
+        PerfCounter& operator=(const PerfCounter&) = delete;
+        void start() {
+            if (m_fd < 0) return;
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        long long stop() {
+            if (m_fd < 0) return -1;
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            long long value = 0;
+            return read(m_fd, &value, sizeof(value)) == sizeof(value) ? value : -1;
+        }
+    private:
+        int m_fd = -1;
+};
+
+template<typename F>
+void bench(const char* name, F&& f) {
+    PerfCounter branchMisses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    PerfCounter icacheMisses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1I |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    branchMisses.start();
+    icacheMisses.start();
+    const auto start = std::chrono::steady_clock::now();
+    const double result = f();
+    const auto stop = std::chrono::steady_clock::now();
+    const auto bm = branchMisses.stop();
+    const auto im = icacheMisses.stop();
+    auto show = [](long long v) { return v < 0 ? std::string("n/a") : std::to_string(v); };
+    std::cout << name << std::chrono::duration<double, std::milli>(stop - start).count()
+              << " ms, branch-misses: " << show(bm) << ", L1i-misses: " << show(im)
+              << " (checksum " << result << ")\n";
+}
+
 int main() {
+    Derived d;
+    d.inheritance();
+
+    Point a{1, 2}, b{1, 3};
+    std::cout << std::boolalpha << "a < b: " << (a < b) << ", a == b: " << (a == b) << std::endl;
+    a.accept([](Point& p) { std::cout << "Visited point " << p.x() << "," << p.y() << std::endl; });
+    {
+        Point c = a;
+        std::cout << "Points live: " << Point::live() << ", created: " << Point::created() << std::endl;
+    }
+    std::cout << "Points live: " << Point::live() << std::endl;
+    std::unique_ptr<IShape> shape = std::make_unique<Square>(3.0);
+    auto copy = shape->clone();
+    std::cout << "Cloned area: " << copy->area() << ", squares live: " << Square::live() << std::endl;
+
+    constexpr std::size_t count = 1'000'000;
+    constexpr int rounds = 20;
+    std::mt19937 rng{7};
+    std::bernoulli_distribution coin{0.5};
+    std::vector<bool> kinds(count);
+    for (std::size_t i = 0; i < count; ++i) kinds[i] = coin(rng);
+
+    // Every dispatch style gets the same two element orders: grouped by type
+    // (circles, then rectangles) and mixed at random. CRTP needs one container per
+    // type, so it only exists grouped; comparing it with the mixed rows would mostly
+    // measure branch prediction, not dispatch cost
+    struct Shapes {
+        std::vector<std::unique_ptr<VShape>> virtuals;
+        std::vector<std::variant<PCircle, PRect>> variants;
+        std::vector<std::function<double()>> functions;
+        void add(bool circle, double v) {
+            if (circle) {
+                virtuals.push_back(std::make_unique<VCircle>(v));
+                variants.emplace_back(PCircle{v});
+                functions.emplace_back([v] { return 3.0 * v * v; });
+            } else {
+                virtuals.push_back(std::make_unique<VRect>(v));
+                variants.emplace_back(PRect{v});
+                functions.emplace_back([v] { return v * 2.0; });
+            }
+        }
+    };
+    std::vector<SCircle> crtpCircles;
+    std::vector<SRect> crtpRects;
+    Shapes grouped, mixed;
+    for (std::size_t i = 0; i < count; ++i) {
+        const double v = static_cast<double>(i % 10);
+        if (kinds[i]) crtpCircles.push_back(SCircle{{}, v});
+        else crtpRects.push_back(SRect{{}, v});
+        mixed.add(kinds[i], v);
+    }
+    for (bool circles : {true, false}) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (kinds[i] == circles) grouped.add(circles, static_cast<double>(i % 10));
+        }
+    }
+
+    std::cout << "Elements: " << count << ", rounds: " << rounds << std::endl;
+    bench("CRTP            grouped: ", [&] {
+        double sum = 0;
+        auto run = [&sum](const auto& items) { for (const auto& s : items) sum += s.area(); };
+        for (int r = 0; r < rounds; ++r) { run(crtpCircles); run(crtpRects); }
+        return sum;
+    });
+    for (const auto* order : {&grouped, &mixed}) {
+        const char* label = order == &grouped ? "grouped: " : "mixed  : ";
+        bench((std::string("virtual         ") + label).c_str(), [&] {
+            double sum = 0;
+            for (int r = 0; r < rounds; ++r) for (const auto& s : order->virtuals) sum += s->area();
+            return sum;
+        });
+        bench((std::string("variant/visit   ") + label).c_str(), [&] {
+            double sum = 0;
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& s : order->variants) sum += std::visit([](const auto& x) { return x.area(); }, s);
+            return sum;
+        });
+        bench((std::string("std::function   ") + label).c_str(), [&] {
+            double sum = 0;
+            for (int r = 0; r < rounds; ++r) for (const auto& f : order->functions) sum += f();
+            return sum;
+        });
+    }
     return 0;
 }
 
 /*-------------Output:----------------/
+a < b: true, a == b: false
+Visited point 1,2
+Points live: 3, created: 3
+Points live: 2
+Cloned area: 9, squares live: 2
+Elements: 1000000, rounds: 20
+CRTP            grouped: 66.9553 ms, branch-misses: n/a, L1i-misses: n/a (checksum 9.44538e+08)
+virtual         grouped: 72.9819 ms, branch-misses: n/a, L1i-misses: n/a (checksum 9.44538e+08)
+variant/visit   grouped: 64.5287 ms, branch-misses: n/a, L1i-misses: n/a (checksum 9.44538e+08)
+std::function   grouped: 68.4301 ms, branch-misses: n/a, L1i-misses: n/a (checksum 9.44538e+08)
+virtual         mixed  : 219.681 ms, branch-misses: n/a, L1i-misses: n/a (checksum 9.44538e+08)
+variant/visit   mixed  : 139.377 ms, branch-misses: n/a, L1i-misses: n/a (checksum 9.44538e+08)
+std::function   mixed  : 187.129 ms, branch-misses: n/a, L1i-misses: n/a (checksum 9.44538e+08)
+(With the same grouped order, the indirect calls are predicted and virtual is
+within ~10% of CRTP. Most of the gap in the mixed rows comes from branch
+mispredictions on the random type sequence, not from the dispatch itself.)
+(hardware counters are n/a inside containers without perf_event access)
 /------------------------------------*/
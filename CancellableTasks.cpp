@@ -0,0 +1,422 @@
+/*----------------------------------------------------------------------------------
+Cooperative cancellation and deadlines
+Once std::async(std::launch::async, compute_square, 10) in FuturesAndAsync.cpp is
+running, the caller can only wait the full two seconds; a request nobody wants
+any more still burns a thread and the CPU. cancel::Executor runs tasks that
+carry a cancel::Context:
+    - a std::stop_token (cancel the work from a std::stop_source) and a deadline.
+      ctx.with_timeout(d) / ctx.with_deadline(t) derive a child context for
+      nested work: same token, the earlier of the two deadlines
+    - scheduling points check it: a task whose context is cancelled or past its
+      deadline when a worker dequeues it is never started, and request_stop()
+      fails a still queued task's future at once (std::stop_callback)
+    - inside a task, ctx.checkpoint() throws cancel::Cancelled and
+      cancel::sleep_for(ctx, d) wakes early; long tasks call them between steps
+    - a cancelled task's future rethrows cancel::Cancelled from get()
+Cancellation is cooperative: code that never reaches a checkpoint runs to the end.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stop_token>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+
+namespace cancel {
+
+using Clock = std::chrono::steady_clock;
+
+struct Cancelled : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+class Context {
+    public:
+        Context() = default;   // never cancelled, no deadline
+        explicit Context(std::stop_token token, Clock::time_point deadline = Clock::time_point::max())
+            : m_token(std::move(token)), m_deadline(deadline) {}
+
+        const std::stop_token& token() const { return m_token; }
+        Clock::time_point deadline() const { return m_deadline; }
+        bool expired() const { return m_deadline != Clock::time_point::max() && Clock::now() >= m_deadline; }
+        bool cancelled() const { return m_token.stop_requested() || expired(); }
+        void checkpoint() const {
+            if (m_token.stop_requested()) throw Cancelled("cancelled");
+            if (expired()) throw Cancelled("deadline exceeded");
+        }
+        Context with_deadline(Clock::time_point deadline) const {
+            return Context(m_token, std::min(m_deadline, deadline));
+        }
+        Context with_timeout(Clock::duration timeout) const { return with_deadline(Clock::now() + timeout); }
+    private:
+        std::stop_token m_token;
+        Clock::time_point m_deadline = Clock::time_point::max();
+};
+
+// Sleeps for d, or less if the context is cancelled or its deadline comes first
+template<typename Rep, typename Period>
+void sleep_for(const Context& ctx, std::chrono::duration<Rep, Period> d) {
+    std::mutex mutex;
+    std::condition_variable_any cv;
+    std::unique_lock lock(mutex);
+    cv.wait_until(lock, ctx.token(), std::min(ctx.deadline(), Clock::now() + d), [] { return false; });
+    ctx.checkpoint();
+}
+
+class Executor {
+    public:
+        explicit Executor(unsigned threads = std::max(2u, std::thread::hardware_concurrency())) {
+            m_workers.reserve(threads);
+            for (unsigned i = 0; i < threads; ++i) {
+                m_workers.emplace_back([this](std::stop_token stop) { workerLoop(stop); });
+            }
+        }
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+        // Running tasks finish (or hit a checkpoint); queued ones are cancelled
+        ~Executor() {
+            for (auto& worker : m_workers) worker.request_stop();
+            for (auto& worker : m_workers) worker.join();
+            for (auto& job : m_queue) job->cancelQueued("executor stopped");
+        }
+
+        // f is called as f(ctx) if it accepts a const Context&, otherwise as f()
+        template<typename F>
+        auto submit(Context ctx, F&& f) {
+            using Fn = std::decay_t<F>;
+            using R = typename std::conditional_t<std::is_invocable_v<Fn&, const Context&>,
+                                                  std::invoke_result<Fn&, const Context&>,
+                                                  std::invoke_result<Fn&>>::type;
+            auto job = std::make_unique<Task<R, Fn>>(std::move(ctx), std::forward<F>(f));
+            auto future = job->promise.get_future();
+            job->watch();
+            {
+                std::lock_guard lock(m_mutex);
+                m_queue.push_back(std::move(job));
+            }
+            m_cv.notify_one();
+            return future;
+        }
+        template<typename F>
+        auto submit(F&& f) { return submit(Context{}, std::forward<F>(f)); }
+
+        struct Stats {
+            std::uint64_t ran, skipped;
+        };
+        Stats stats() const { return {m_ran.load(), m_skipped.load()}; }
+    private:
+        static constexpr std::uint32_t Queued = 0, Running = 1, Done = 2;
+
+        struct Job {
+            explicit Job(Context c) : ctx(std::move(c)) {}
+            virtual ~Job() = default;
+            virtual void run() = 0;
+            virtual void fail(std::exception_ptr error) = 0;
+            // Only one of the worker and the stop callback gets past Queued
+            bool claim(std::uint32_t next) {
+                auto expected = Queued;
+                return state.compare_exchange_strong(expected, next, std::memory_order_acq_rel);
+            }
+            bool cancelQueued(const char* why) {
+                if (!claim(Done)) return false;
+                fail(std::make_exception_ptr(Cancelled(why)));
+                return true;
+            }
+            struct OnStop {
+                Job* job;
+                void operator()() const noexcept { job->cancelQueued("cancelled"); }
+            };
+            void watch() {
+                if (ctx.token().stop_possible()) onStop.emplace(ctx.token(), OnStop{this});
+            }
+
+            Context ctx;
+            std::atomic<std::uint32_t> state{Queued};
+            // Its destructor waits for a callback running on another thread
+            std::optional<std::stop_callback<OnStop>> onStop;
+        };
+
+        template<typename R, typename F>
+        struct Task final : Job {
+            Task(Context c, F&& f) : Job(std::move(c)), fn(std::move(f)) {}
+            Task(Context c, const F& f) : Job(std::move(c)), fn(f) {}
+            // Unregister before the promise goes away
+            ~Task() override { this->onStop.reset(); }
+            void run() override {
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        call();
+                        promise.set_value();
+                    } else {
+                        promise.set_value(call());
+                    }
+                } catch (...) {
+                    promise.set_exception(std::current_exception());
+                }
+            }
+            void fail(std::exception_ptr error) override { promise.set_exception(error); }
+            decltype(auto) call() {
+                if constexpr (std::is_invocable_v<F&, const Context&>) return fn(this->ctx);
+                else return fn();
+            }
+            F fn;
+            std::promise<R> promise;
+        };
+
+        void workerLoop(std::stop_token stop) {
+            while (true) {
+                std::unique_ptr<Job> job;
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_cv.wait(lock, stop, [this] { return !m_queue.empty(); });
+                    // wait() also returns true after a stop if work is queued; leave that work to
+                    // ~Executor, which cancels it
+                    if (stop.stop_requested()) return;
+                    job = std::move(m_queue.front());
+                    m_queue.pop_front();
+                }
+                // Scheduling point: work cancelled while it was queued never starts
+                if (job->ctx.token().stop_requested()) {
+                    job->cancelQueued("cancelled");
+                    m_skipped.fetch_add(1, std::memory_order_relaxed);
+                } else if (job->ctx.expired()) {
+                    job->cancelQueued("deadline exceeded");
+                    m_skipped.fetch_add(1, std::memory_order_relaxed);
+                } else if (job->claim(Running)) {
+                    job->run();
+                    m_ran.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    m_skipped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable_any m_cv;
+        std::deque<std::unique_ptr<Job>> m_queue;
+        std::atomic<std::uint64_t> m_ran{0}, m_skipped{0};
+        std::vector<std::jthread> m_workers;   // last: started after everything else exists
+};
+
+}   // namespace cancel
+
+int compute_square(const cancel::Context& ctx, int x) {
+    cancel::sleep_for(ctx, std::chrono::seconds(2)); // Simulate Heavy Computation
+    return x * x;
+}
+int process_data(const cancel::Context& ctx, int id) {
+    cancel::sleep_for(ctx, std::chrono::seconds(1));
+    return id * id;
+}
+
+// CPU time of the calling thread, for the benchmark
+static double threadCpuMs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+// 'us' microseconds of CPU work, measured on this thread's CPU clock so that the
+// cost does not depend on how often the thread is preempted
+static void burn(double us) {
+    const double until = threadCpuMs() + us / 1e3;
+    volatile std::uint64_t sink = 0;
+    while (threadCpuMs() < until) {
+        for (int i = 0; i < 1000; ++i) sink = sink + i;
+    }
+}
+
+struct ShedResult {
+    int onTime = 0, late = 0, cancelled = 0;
+    double cpuMs = 0, wastedCpuMs = 0, drainMs = 0;
+};
+
+// Requests arrive every 'gap' and each needs 'chunks' x 50 us of CPU, more than
+// the workers can serve; a result is only useful before its deadline. With
+// honourDeadline the task carries the deadline and checks it between chunks.
+ShedResult shed(bool honourDeadline, int requests, std::chrono::microseconds gap, int chunks,
+                std::chrono::milliseconds deadline) {
+    struct Outcome {
+        double cpuMs = 0;
+        cancel::Clock::time_point finished, deadline;
+    };
+    std::vector<Outcome> outcomes(requests);
+    std::vector<std::future<void>> futures;
+    futures.reserve(requests);
+    const auto start = cancel::Clock::now();
+    {
+        cancel::Executor executor(2);
+        for (int i = 0; i < requests; ++i) {
+            std::this_thread::sleep_until(start + i * gap);
+            auto& outcome = outcomes[i];
+            outcome.deadline = cancel::Clock::now() + deadline;
+            cancel::Context ctx = honourDeadline ? cancel::Context(std::stop_token{}, outcome.deadline) : cancel::Context{};
+            futures.push_back(executor.submit(ctx, [&outcome, chunks](const cancel::Context& ctx) {
+                const double cpuStart = threadCpuMs();
+                struct Account {
+                    Outcome& outcome;
+                    double cpuStart;
+                    ~Account() {
+                        outcome.cpuMs = threadCpuMs() - cpuStart;
+                        outcome.finished = cancel::Clock::now();
+                    }
+                } account{outcome, cpuStart};
+                for (int c = 0; c < chunks; ++c) {
+                    ctx.checkpoint();
+                    burn(50);
+                }
+            }));
+        }
+        ShedResult r;
+        for (int i = 0; i < requests; ++i) {
+            try {
+                futures[i].get();
+                (outcomes[i].finished <= outcomes[i].deadline ? r.onTime : r.late) += 1;
+                if (outcomes[i].finished > outcomes[i].deadline) r.wastedCpuMs += outcomes[i].cpuMs;
+            } catch (const cancel::Cancelled&) {
+                r.cancelled += 1;
+                r.wastedCpuMs += outcomes[i].cpuMs;
+            }
+            r.cpuMs += outcomes[i].cpuMs;
+        }
+        r.drainMs = std::chrono::duration<double, std::milli>(cancel::Clock::now() - start).count();
+        return r;
+    }
+}
+
+int main() {
+    using namespace std::chrono_literals;
+    cancel::Executor executor(2);
+    {
+        // Heap allocated only because GCC 12 flags a local stop_source with -Wmaybe-uninitialized
+        auto owner = std::make_unique<std::stop_source>();
+        auto& source = *owner;
+        const auto start = cancel::Clock::now();
+        auto result = executor.submit(cancel::Context(source.get_token()),
+                                      [](const cancel::Context& ctx) { return compute_square(ctx, 10); });
+        std::cout << "Doing other work..." << std::endl;
+        std::this_thread::sleep_for(100ms);
+        source.request_stop();   // the caller no longer needs the square
+        try {
+            const int square = result.get();
+            std::cout << "The square of 10 is: " << square << std::endl;
+        } catch (const cancel::Cancelled& e) {
+            std::cout << "compute_square: " << e.what() << " after "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(cancel::Clock::now() - start).count()
+                      << " ms instead of 2000 ms" << std::endl;
+        }
+    }
+    {
+        // The parent's 300 ms budget bounds the child even though it asks for 5 s
+        cancel::Context request = cancel::Context().with_timeout(300ms);
+        auto parent = executor.submit(request, [&executor](const cancel::Context& ctx) {
+            auto child = executor.submit(ctx.with_timeout(5s), [](const cancel::Context& ctx) { return process_data(ctx, 7); });
+            return child.get();
+        });
+        try {
+            const int processed = parent.get();
+            std::cout << "Processed result: " << processed << std::endl;
+        } catch (const cancel::Cancelled& e) {
+            std::cout << "process_data: " << e.what() << std::endl;
+        }
+    }
+    {
+        // One worker is busy; the five queued tasks are cancelled before they start
+        cancel::Executor single(1);
+        auto blocker = single.submit([] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+        auto owner = std::make_unique<std::stop_source>();
+        auto& source = *owner;
+        std::atomic<int> started{0};
+        std::vector<std::future<int>> futures;
+        for (int id = 1; id <= 5; ++id) {
+            futures.push_back(single.submit(cancel::Context(source.get_token()), [&started, id] {
+                started.fetch_add(1);
+                return id * id;
+            }));
+        }
+        source.request_stop();
+        int cancelledCount = 0;
+        for (auto& future : futures) {
+            try {
+                future.get();
+            } catch (const cancel::Cancelled&) {
+                ++cancelledCount;
+            }
+        }
+        blocker.get();
+        std::cout << "Queued tasks cancelled: " << cancelledCount << ", started: " << started.load() << std::endl;
+    }
+    {
+        // Destroying the executor finishes the running task and cancels the queued ones
+        std::atomic<bool> running{false};
+        std::atomic<int> started{0};
+        std::vector<std::future<int>> futures;
+        {
+            cancel::Executor single(1);
+            futures.push_back(single.submit([&running] {
+                running.store(true);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                return 0;
+            }));
+            for (int id = 1; id <= 5; ++id) {
+                futures.push_back(single.submit([&started, id] {
+                    started.fetch_add(1);
+                    return id * id;
+                }));
+            }
+            while (!running.load()) std::this_thread::yield();
+        }
+        int completed = 0, stopped = 0;
+        for (auto& future : futures) {
+            try {
+                future.get();
+                ++completed;
+            } catch (const cancel::Cancelled& e) {
+                stopped += std::string(e.what()) == "executor stopped";
+            }
+        }
+        std::cout << "Executor destroyed: completed " << completed << ", cancelled " << stopped
+                  << ", started after stop: " << started.load() << std::endl;
+    }
+
+    constexpr int requests = 400, chunks = 20;   // 1 ms of CPU per request
+    constexpr auto gap = 500us;                  // 2 requests per ms offered
+    constexpr auto deadline = 20ms;
+    std::cout << requests << " requests, 1 ms CPU each, one every 0.5 ms, 20 ms deadline, 2 workers" << std::endl;
+    std::cout << "mode | on time | late | cancelled | worker CPU ms | wasted CPU ms | drain ms" << std::endl;
+    for (bool honour : {false, true}) {
+        const auto r = shed(honour, requests, gap, chunks, deadline);
+        std::cout << (honour ? "deadline + cancellation" : "run everything") << " | " << r.onTime << " | " << r.late
+                  << " | " << r.cancelled << " | " << r.cpuMs << " | " << r.wastedCpuMs << " | " << r.drainMs << std::endl;
+    }
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Doing other work...
+compute_square: cancelled after 100 ms instead of 2000 ms
+process_data: deadline exceeded
+Queued tasks cancelled: 5, started: 0
+Executor destroyed: completed 1, cancelled 5, started after stop: 0
+400 requests, 1 ms CPU each, one every 0.5 ms, 20 ms deadline, 2 workers
+mode | on time | late | cancelled | worker CPU ms | wasted CPU ms | drain ms
+run everything | 34 | 366 | 0 | 410.202 | 375.328 | 431.123
+deadline + cancellation | 36 | 1 | 363 | 214.871 | 177.966 | 219.601
+Twice as much work arrives as one core can do. Running everything burns 410 ms of
+CPU, and 92% of it produces answers after their deadline. With deadlines on the
+tasks, expired requests still queued are dropped without running. Started ones stop
+at the next 50 us checkpoint, so CPU use halves while the on-time count stays the
+same. What is still wasted comes from requests that start just before their
+deadline and are abandoned partway through.
+-------------------------------------------------------------*/
@@ -0,0 +1,430 @@
+/*----------------------------------------------------------------------------------
+Futures with continuations, when_all and when_any
+FuturesAndAsync.cpp keeps a vector of std::future<int> and calls fut.get() on them
+in order: a result that is ready early still waits for every slower task queued
+in front of it, and the collecting thread does nothing but block.
+cf::Future<T> can instead say what should happen with the result:
+    - then(executor, f) returns a Future of f's result. f runs on the executor as
+      soon as the value is there, nobody waits for it. An exception skips f and
+      goes straight to the returned future, like a failed std::future::get()
+    - when_all(futures) is ready with all values (in input order) once the last
+      one is; the first exception fails it right away
+    - when_any(futures) is ready with {index, value} of the first one to finish;
+      with no futures it fails right away with std::invalid_argument instead of
+      never becoming ready
+Both combinators only register a callback on each input, so they do not hold a
+thread while they wait; the callback that completes them runs on the thread that
+delivered the last (or first) value. get() still blocks for code that wants it.
+Any type with execute(std::function<void()>) can serve as the executor.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <variant>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <utility>
+
+namespace cf {
+
+template<typename E>
+concept Executor = requires(E& executor, std::function<void()> fn) { executor.execute(std::move(fn)); };
+
+class ThreadPool {
+    public:
+        explicit ThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+            for (std::size_t i = 0; i < threads; ++i) {
+                m_workers.emplace_back([this] { run(); });
+            }
+        }
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            for (auto& worker : m_workers) worker.join();
+        }
+        void execute(std::function<void()> fn) {
+            {
+                std::lock_guard lock(m_mutex);
+                m_queue.push_back(std::move(fn));
+            }
+            m_cv.notify_one();
+        }
+    private:
+        void run() {
+            for (;;) {
+                std::function<void()> fn;
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                    if (m_queue.empty()) return;
+                    fn = std::move(m_queue.front());
+                    m_queue.pop_front();
+                }
+                fn();
+            }
+        }
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<std::function<void()>> m_queue;
+        bool m_stop = false;
+        std::vector<std::thread> m_workers;
+};
+
+namespace detail {
+    template<typename T>
+    class State {
+        public:
+            using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+            void set_value(Value value) { complete([&] { m_result.template emplace<1>(std::move(value)); }); }
+            void set_exception(std::exception_ptr error) { complete([&] { m_result.template emplace<2>(error); }); }
+            // Runs callback once the result is there: now, or on the completing thread
+            void subscribe(std::function<void()> callback) {
+                std::unique_lock lock(m_mutex);
+                if (!m_ready) {
+                    m_callback = std::move(callback);
+                    return;
+                }
+                lock.unlock();
+                callback();
+            }
+            void wait() {
+                std::unique_lock lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_ready; });
+            }
+            bool ready() {
+                std::lock_guard lock(m_mutex);
+                return m_ready;
+            }
+            // Only after wait() or from a subscribed callback
+            bool has_error() const { return m_result.index() == 2; }
+            std::exception_ptr error() const { return std::get<2>(m_result); }
+            Value take() { return std::move(std::get<1>(m_result)); }
+        private:
+            template<typename Store>
+            void complete(Store store) {
+                std::function<void()> callback;
+                {
+                    std::lock_guard lock(m_mutex);
+                    if (m_ready) throw std::future_error(std::future_errc::promise_already_satisfied);
+                    store();
+                    m_ready = true;
+                    callback = std::move(m_callback);
+                }
+                m_cv.notify_all();
+                if (callback) callback();
+            }
+            std::mutex m_mutex;
+            std::condition_variable m_cv;
+            bool m_ready = false;
+            std::variant<std::monostate, Value, std::exception_ptr> m_result;
+            std::function<void()> m_callback;
+    };
+
+    // Calls fn(args...) and stores its result (or exception) in state
+    template<typename R, typename F, typename... Args>
+    void fulfil(State<R>& state, F& fn, Args&&... args) {
+        try {
+            if constexpr (std::is_void_v<R>) {
+                std::invoke(fn, std::forward<Args>(args)...);
+                state.set_value({});
+            } else {
+                state.set_value(std::invoke(fn, std::forward<Args>(args)...));
+            }
+        } catch (...) {
+            state.set_exception(std::current_exception());
+        }
+    }
+}
+
+template<typename T> class Future;
+
+template<typename T>
+class Promise {
+    public:
+        Promise() : m_state(std::make_shared<detail::State<T>>()) {}
+        Future<T> get_future() { return Future<T>(m_state); }
+        template<typename U = T>
+        requires (!std::is_void_v<U>)
+        void set_value(U value) { m_state->set_value(std::move(value)); }
+        void set_value() requires std::is_void_v<T> { m_state->set_value({}); }
+        void set_exception(std::exception_ptr error) { m_state->set_exception(error); }
+    private:
+        std::shared_ptr<detail::State<T>> m_state;
+};
+
+template<typename T>
+class Future {
+    public:
+        Future() = default;
+        explicit Future(std::shared_ptr<detail::State<T>> state) : m_state(std::move(state)) {}
+
+        bool valid() const { return m_state != nullptr; }
+        bool is_ready() const { return m_state->ready(); }
+        T get() {
+            auto state = std::move(m_state);
+            state->wait();
+            if (state->has_error()) std::rethrow_exception(state->error());
+            if constexpr (!std::is_void_v<T>) return state->take();
+        }
+        // Consumes this future; f(value) (or f() for void) runs on executor
+        template<Executor E, typename F>
+        auto then(E& executor, F f) {
+            using R = std::conditional_t<std::is_void_v<T>, std::invoke_result<F>, std::invoke_result<F, T>>::type;
+            auto next = std::make_shared<detail::State<R>>();
+            auto state = std::move(m_state);
+            state->subscribe([&executor, state, next, f = std::move(f)]() mutable {
+                if (state->has_error()) {
+                    next->set_exception(state->error());
+                    return;
+                }
+                executor.execute([state, next, f = std::move(f)]() mutable {
+                    if constexpr (std::is_void_v<T>) {
+                        detail::fulfil(*next, f);
+                    } else {
+                        detail::fulfil(*next, f, state->take());
+                    }
+                });
+            });
+            return Future<R>(next);
+        }
+        // For the combinators: callback(state) once the result is there
+        template<typename Callback>
+        void on_ready(Callback callback) {
+            auto state = std::move(m_state);
+            state->subscribe([state, callback = std::move(callback)]() mutable { callback(*state); });
+        }
+    private:
+        std::shared_ptr<detail::State<T>> m_state;
+};
+
+// Runs f on the executor, like std::async on a pool
+template<Executor E, typename F>
+auto async(E& executor, F f) {
+    using R = std::invoke_result_t<F&>;
+    auto state = std::make_shared<detail::State<R>>();
+    executor.execute([state, f = std::move(f)]() mutable { detail::fulfil(*state, f); });
+    return Future<R>(state);
+}
+
+template<typename T>
+requires (!std::is_void_v<T>)
+Future<std::vector<T>> when_all(std::vector<Future<T>> futures) {
+    struct Shared {
+        explicit Shared(std::size_t n) : values(n), remaining(n) {}
+        std::vector<T> values;
+        std::atomic<std::size_t> remaining;
+        std::atomic<bool> failed{false};
+        Promise<std::vector<T>> promise;
+    };
+    auto shared = std::make_shared<Shared>(futures.size());
+    auto result = shared->promise.get_future();
+    if (futures.empty()) shared->promise.set_value({});
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+        futures[i].on_ready([shared, i](detail::State<T>& state) {
+            if (state.has_error()) {
+                if (!shared->failed.exchange(true)) shared->promise.set_exception(state.error());
+                return;
+            }
+            shared->values[i] = state.take();
+            // acq_rel: the last one sees every slot written by the others
+            if (shared->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !shared->failed.exchange(true)) {
+                shared->promise.set_value(std::move(shared->values));
+            }
+        });
+    }
+    return result;
+}
+
+template<typename T>
+requires (!std::is_void_v<T>)
+Future<std::pair<std::size_t, T>> when_any(std::vector<Future<T>> futures) {
+    struct Shared {
+        std::atomic<bool> done{false};
+        Promise<std::pair<std::size_t, T>> promise;
+    };
+    auto shared = std::make_shared<Shared>();
+    auto result = shared->promise.get_future();
+    if (futures.empty()) {
+        shared->promise.set_exception(std::make_exception_ptr(std::invalid_argument("when_any of no futures")));
+    }
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+        futures[i].on_ready([shared, i](detail::State<T>& state) {
+            if (shared->done.exchange(true)) return;
+            if (state.has_error()) {
+                shared->promise.set_exception(state.error());
+            } else {
+                shared->promise.set_value({i, state.take()});
+            }
+        });
+    }
+    return result;
+}
+
+}   // namespace cf
+
+using Clock = std::chrono::steady_clock;
+
+int process_data(int id, std::chrono::microseconds duration) {
+    std::this_thread::sleep_for(duration);
+    return id * id;
+}
+
+struct FanResult {
+    double handleDelayUs = 0;   // mean time from a task finishing to its result being handled
+    double fanInUs = 0;         // last task finished -> combined result available
+    double firstUs = 0;         // start -> first result handled
+};
+
+// 64 tasks, most take 500 us, every 8th takes 10 ms, in random positions
+std::vector<std::chrono::microseconds> skewed_durations(std::mt19937& rng) {
+    std::vector<std::chrono::microseconds> durations(64, std::chrono::microseconds(500));
+    for (std::size_t i = 0; i < durations.size(); i += 8) durations[i] = std::chrono::milliseconds(10);
+    std::shuffle(durations.begin(), durations.end(), rng);
+    return durations;
+}
+
+double us(Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); }
+
+FanResult fan_std_async(const std::vector<std::chrono::microseconds>& durations) {
+    const auto n = durations.size();
+    std::vector<Clock::time_point> finished(n);
+    const auto start = Clock::now();
+    std::vector<std::future<int>> futures;
+    for (std::size_t id = 0; id < n; ++id) {
+        futures.push_back(std::async(std::launch::async, [&finished, &durations, id] {
+            const int result = process_data(static_cast<int>(id), durations[id]);
+            finished[id] = Clock::now();
+            return result;
+        }));
+    }
+    FanResult r;
+    long total = 0;
+    for (std::size_t id = 0; id < n; ++id) {
+        total += futures[id].get();   // in order, as in FuturesAndAsync.cpp
+        const auto handled = Clock::now();
+        r.handleDelayUs += us(handled - finished[id]) / n;
+        if (id == 0) r.firstUs = us(handled - start);
+    }
+    r.fanInUs = us(Clock::now() - *std::max_element(finished.begin(), finished.end()));
+    if (total < 0) std::cout << total;
+    return r;
+}
+
+FanResult fan_continuations(cf::ThreadPool& pool, const std::vector<std::chrono::microseconds>& durations) {
+    const auto n = durations.size();
+    std::vector<Clock::time_point> finished(n), handled(n);
+    const auto start = Clock::now();
+    std::vector<cf::Future<int>> futures;
+    for (std::size_t id = 0; id < n; ++id) {
+        auto future = cf::async(pool, [&finished, &durations, id] {
+            const int result = process_data(static_cast<int>(id), durations[id]);
+            finished[id] = Clock::now();
+            return result;
+        });
+        // handle each result on its own as soon as it is there
+        futures.push_back(std::move(future).then(pool, [&handled, id](int value) {
+            handled[id] = Clock::now();
+            return value;
+        }));
+    }
+    auto all = cf::when_all(std::move(futures));
+    std::vector<int> values = all.get();
+    const auto allReady = Clock::now();
+    FanResult r;
+    for (std::size_t id = 0; id < n; ++id) r.handleDelayUs += us(handled[id] - finished[id]) / n;
+    r.fanInUs = us(allReady - *std::max_element(finished.begin(), finished.end()));
+    r.firstUs = us(*std::min_element(handled.begin(), handled.end()) - start);
+    return r;
+}
+
+int main() {
+    cf::ThreadPool pool(64);   // the benchmark tasks sleep, so one thread per task like std::async
+    {
+        std::vector<int> ids = {1, 2, 3, 4, 5};
+        std::vector<cf::Future<int>> futures;
+        for (int id : ids) {
+            auto duration = std::chrono::milliseconds(60 - 10 * id);   // the first one is the slowest
+            futures.push_back(cf::async(pool, [id, duration] { return process_data(id, duration); })
+                .then(pool, [](int result) {
+                    std::cout << "Processed result: " << result << std::endl;
+                    return result;
+                }));
+        }
+        int sum = 0;
+        for (int v : cf::when_all(std::move(futures)).get()) sum += v;
+        std::cout << "when_all sum: " << sum << std::endl;
+    }
+    {
+        std::vector<cf::Future<int>> racers;
+        racers.push_back(cf::async(pool, [] { return process_data(7, std::chrono::milliseconds(30)); }));
+        racers.push_back(cf::async(pool, [] { return process_data(8, std::chrono::milliseconds(5)); }));
+        auto [index, value] = cf::when_any(std::move(racers)).get();
+        std::cout << "when_any: future " << index << " won with " << value << std::endl;
+        try {
+            cf::when_any(std::vector<cf::Future<int>>{}).get();
+        } catch (const std::invalid_argument& e) {
+            std::cout << "Caught exception: " << e.what() << std::endl;
+        }
+    }
+    try {
+        cf::async(pool, []() -> int { throw std::runtime_error("An error occured during computation!"); })
+            .then(pool, [](int value) { return value + 1; })   // skipped
+            .get();
+    } catch (const std::exception& e) {
+        std::cout << "Caught exception: " << e.what() << std::endl;
+    }
+
+    constexpr int rounds = 20;
+    std::mt19937 rng(3);
+    FanResult a, c;
+    for (int round = 0; round < rounds; ++round) {
+        const auto durations = skewed_durations(rng);
+        const auto ra = fan_std_async(durations);
+        const auto rc = fan_continuations(pool, durations);
+        a.handleDelayUs += ra.handleDelayUs / rounds;
+        a.fanInUs += ra.fanInUs / rounds;
+        a.firstUs += ra.firstUs / rounds;
+        c.handleDelayUs += rc.handleDelayUs / rounds;
+        c.fanInUs += rc.fanInUs / rounds;
+        c.firstUs += rc.firstUs / rounds;
+    }
+    std::cout << "64 tasks (8 x 10 ms, 56 x 0.5 ms), mean of " << rounds << " rounds" << std::endl;
+    std::cout << "approach | result handled after task end us | fan-in us | first result handled us" << std::endl;
+    std::cout << "std::async + get() in order | " << a.handleDelayUs << " | " << a.fanInUs << " | " << a.firstUs << std::endl;
+    std::cout << "then() + when_all | " << c.handleDelayUs << " | " << c.fanInUs << " | " << c.firstUs << std::endl;
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Processed result: 25
+Processed result: 16
+Processed result: 9
+Processed result: 4
+Processed result: 1
+when_all sum: 55
+when_any: future 1 won with 64
+Caught exception: when_any of no futures
+Caught exception: An error occured during computation!
+64 tasks (8 x 10 ms, 56 x 0.5 ms), mean of 20 rounds
+approach | result handled after task end us | fan-in us | first result handled us
+std::async + get() in order | 7273.95 | 96.4957 | 2816.96
+then() + when_all | 6.76668 | 10.7742 | 591.702
+The in-order get() hands most results over milliseconds after they were ready,
+because a 10 ms task usually sits near the front. With then() each result is
+handled a few microseconds after its task ends, and when_all completes as soon as
+the last continuation has run.
+-------------------------------------------------------------*/
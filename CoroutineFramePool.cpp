@@ -0,0 +1,349 @@
+/*----------------------------------------------------------------------------------
+Pooled coroutine frames
+Every call to async_wait (Coroutines.cpp) or example_coroutine (C++20.cpp) creates
+a coroutine frame with the global operator new, unless the compiler proves the
+frame cannot outlive the caller and puts it in the caller's frame (HALO, heap
+allocation elision; Clang does it for inlined, caller-owned coroutines, GCC 12
+never does). A promise_type can supply its own operator new/operator delete,
+which is then used for the whole frame. framepool::PooledFrame is such a policy:
+    - struct promise_type : framepool::PooledFrame { ... } is all it takes
+    - frame sizes are rounded up to size classes (64 .. 2048 bytes, frames larger
+      than that go to ::operator new); every block starts with a 16 byte header
+      naming its class and the thread cache that carved it
+    - each thread has a cache with a free list per class, so creating and
+      destroying frames on one thread is a pointer pop/push, no locks, no malloc
+      once the cache is warm (slabs of 64 KiB are carved on demand)
+    - a frame destroyed on another thread is pushed onto its owner's lock-free
+      remote list for that class; the owner takes the whole list back with one
+      exchange when its local list runs dry (no ABA: only the owner pops)
+    - a thread's cache outlives the thread: on exit it is parked and adopted by
+      the next thread that starts, so remote frees never dangle
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <coroutine>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <exception>
+#include <utility>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+namespace framepool {
+
+inline constexpr std::size_t ClassSizes[] = {64, 128, 256, 512, 1024, 2048};
+inline constexpr std::size_t Classes = std::size(ClassSizes);
+inline constexpr std::size_t HeaderSize = 16;   // keeps the frame 16-byte aligned
+inline constexpr std::size_t SlabBytes = 64 * 1024;
+inline constexpr std::uint32_t Large = ~0u;
+
+class ThreadCache;
+
+struct Header {
+    ThreadCache* owner;
+    std::uint32_t sizeClass;
+};
+static_assert(sizeof(Header) <= HeaderSize);
+
+constexpr std::uint32_t classFor(std::size_t bytes) {
+    for (std::uint32_t c = 0; c < Classes; ++c) {
+        if (bytes <= ClassSizes[c]) return c;
+    }
+    return Large;
+}
+
+// Slab growth, for the benchmark to show that warm caches never get here
+inline std::atomic<std::size_t> g_slabs{0};
+
+class ThreadCache {
+    public:
+        void* allocate(std::uint32_t sizeClass) {
+            FreeBlock*& head = m_free[sizeClass];
+            if (!head) head = m_remote[sizeClass].exchange(nullptr, std::memory_order_acquire);
+            if (!head) refill(sizeClass);
+            FreeBlock* block = head;
+            head = block->next;
+            return block;
+        }
+        void deallocateLocal(void* block, std::uint32_t sizeClass) {
+            auto* freed = static_cast<FreeBlock*>(block);
+            freed->next = m_free[sizeClass];
+            m_free[sizeClass] = freed;
+        }
+        // Any thread
+        void deallocateRemote(void* block, std::uint32_t sizeClass) {
+            auto* freed = static_cast<FreeBlock*>(block);
+            freed->next = m_remote[sizeClass].load(std::memory_order_relaxed);
+            while (!m_remote[sizeClass].compare_exchange_weak(freed->next, freed, std::memory_order_release,
+                                                              std::memory_order_relaxed)) {}
+        }
+
+        // nullptr once this thread's cache has been parked at thread exit
+        static ThreadCache* current() { return t_cache; }
+        static ThreadCache& local() {
+            thread_local Holder holder;
+            return *holder.cache;
+        }
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+        struct Parked {
+            std::mutex mutex;
+            std::vector<ThreadCache*> caches;
+        };
+        // Leaked on purpose: caches (and this list) must outlive every thread
+        static Parked& parked() {
+            static Parked* p = new Parked;
+            return *p;
+        }
+        struct Holder {
+            ThreadCache* cache;
+            Holder() {
+                {
+                    std::lock_guard lock(parked().mutex);
+                    if (!parked().caches.empty()) {
+                        cache = parked().caches.back();
+                        parked().caches.pop_back();
+                    } else {
+                        cache = new ThreadCache;
+                    }
+                }
+                t_cache = cache;
+            }
+            ~Holder() {
+                t_cache = nullptr;
+                std::lock_guard lock(parked().mutex);
+                parked().caches.push_back(cache);
+            }
+        };
+        static inline thread_local ThreadCache* t_cache = nullptr;
+
+        void refill(std::uint32_t sizeClass) {
+            auto* slab = static_cast<std::byte*>(std::malloc(SlabBytes));
+            if (!slab) throw std::bad_alloc();
+            g_slabs.fetch_add(1, std::memory_order_relaxed);
+            const std::size_t size = ClassSizes[sizeClass];
+            for (std::size_t offset = 0; offset + size <= SlabBytes; offset += size) {
+                deallocateLocal(slab + offset, sizeClass);
+            }
+        }
+
+        FreeBlock* m_free[Classes] = {};
+        alignas(64) std::atomic<FreeBlock*> m_remote[Classes] = {};
+};
+
+inline void* allocate(std::size_t frameSize) {
+    const std::uint32_t sizeClass = classFor(frameSize + HeaderSize);
+    ThreadCache* owner = nullptr;
+    void* block;
+    if (sizeClass == Large) {
+        block = ::operator new(frameSize + HeaderSize);
+    } else {
+        owner = &ThreadCache::local();
+        block = owner->allocate(sizeClass);
+    }
+    ::new (block) Header{owner, sizeClass};
+    return static_cast<std::byte*>(block) + HeaderSize;
+}
+
+inline void deallocate(void* frame) noexcept {
+    void* block = static_cast<std::byte*>(frame) - HeaderSize;
+    const Header header = *static_cast<Header*>(block);
+    if (header.sizeClass == Large) {
+        ::operator delete(block);
+    } else if (header.owner == ThreadCache::current()) {
+        header.owner->deallocateLocal(block, header.sizeClass);
+    } else {
+        header.owner->deallocateRemote(block, header.sizeClass);
+    }
+}
+
+// Allocation policy: derive the promise_type from it
+struct PooledFrame {
+    static void* operator new(std::size_t size) { return allocate(size); }
+    static void operator delete(void* frame, std::size_t) noexcept { deallocate(frame); }
+};
+
+}   // namespace framepool
+
+// Counts every global allocation, to show which variants reach malloc
+static std::atomic<std::size_t> g_allocations{0};
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Default policy: the frame comes from the global operator new
+struct DefaultFrame {};
+// Global operator new, but counts the frames that were not elided
+static std::atomic<std::size_t> g_frameAllocations{0};
+struct CountingFrame {
+    static void* operator new(std::size_t size) {
+        g_frameAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    static void operator delete(void* frame, std::size_t size) noexcept { ::operator delete(frame, size); }
+};
+
+// A lazy coroutine returning T, with the frame allocation policy as a parameter
+template<typename T, typename Alloc = framepool::PooledFrame>
+class Lazy {
+    public:
+        struct promise_type : Alloc {
+            T value{};
+            std::exception_ptr error;
+            Lazy get_return_object() noexcept { return Lazy(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_always final_suspend() const noexcept { return {}; }
+            void return_value(T v) { value = std::move(v); }
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+        Lazy(Lazy&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Lazy& operator=(Lazy&& other) noexcept {
+            if (this != &other) {
+                if (m_handle) m_handle.destroy();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+        ~Lazy() { if (m_handle) m_handle.destroy(); }
+        T run() {
+            m_handle.resume();
+            if (m_handle.promise().error) std::rethrow_exception(m_handle.promise().error);
+            return std::move(m_handle.promise().value);
+        }
+    private:
+        explicit Lazy(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+        std::coroutine_handle<promise_type> m_handle;
+};
+
+template<typename Alloc>
+Lazy<int, Alloc> example_coroutine(int x) {
+    co_return x * 2;
+}
+// Keeps a buffer alive across a suspension point, so it lives in the frame
+template<typename Alloc>
+Lazy<int, Alloc> large_coroutine(int x) {
+    volatile char buffer[600];
+    buffer[x % 600] = static_cast<char>(x);
+    co_await std::suspend_never{};
+    co_return buffer[x % 600];
+}
+
+static volatile long g_sink;
+
+template<typename Make>
+void sameThread(const char* name, Make make) {
+    constexpr int frames = 5'000'000;
+    long sum = 0;
+    for (int i = 0; i < 1000; ++i) sum += make(i).run();   // warm up the cache
+    const auto allocations = g_allocations.load();
+    const auto slabs = framepool::g_slabs.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) sum += make(i).run();
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << " | " << ns / frames << " | " << 1e3 / (ns / frames) << " | "
+              << static_cast<double>(g_allocations.load() - allocations + framepool::g_slabs.load() - slabs) / frames << std::endl;
+    g_sink = sum;
+}
+
+// Frames are created on one thread and destroyed on another, in batches
+template<typename Make>
+void crossThread(const char* name, Make make) {
+    using Frame = decltype(make(0));
+    constexpr int frames = 2'000'000, batch = 1024;
+    std::mutex mutex;
+    std::vector<std::vector<Frame>> handoff;
+    std::atomic<bool> producing{true};
+    const auto allocations = g_allocations.load();
+    const auto slabs = framepool::g_slabs.load();
+    const auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+        while (true) {
+            std::vector<std::vector<Frame>> taken;
+            {
+                std::lock_guard lock(mutex);
+                taken.swap(handoff);
+            }
+            if (taken.empty()) {
+                if (!producing.load()) break;
+                std::this_thread::yield();
+            }
+            // destroying the Lazy objects frees the frames on this thread
+        }
+    });
+    for (int i = 0; i < frames; i += batch) {
+        std::vector<Frame> created;
+        created.reserve(batch);
+        for (int j = 0; j < batch; ++j) created.push_back(make(i + j));
+        std::lock_guard lock(mutex);
+        handoff.push_back(std::move(created));
+    }
+    producing.store(false);
+    consumer.join();
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    // the batch vectors account for the 0.001 mallocs per frame
+    std::cout << name << " | " << ns / frames << " | " << 1e3 / (ns / frames) << " | "
+              << static_cast<double>(g_allocations.load() - allocations) / frames << " | "
+              << framepool::g_slabs.load() - slabs << std::endl;
+}
+
+int main() {
+    {
+        auto task = example_coroutine<framepool::PooledFrame>(21);
+        std::cout << "Coroutine result: " << task.run() << std::endl;
+    }
+    {
+        // HALO: frames of coroutines created and finished inside one caller can be
+        // elided; count how many still went through operator new
+        constexpr int calls = 1000;
+        long sum = 0;
+        g_frameAllocations = 0;
+        for (int i = 0; i < calls; ++i) sum += example_coroutine<CountingFrame>(i).run();
+        const auto allocated = g_frameAllocations.load();
+        std::cout << "HALO: " << calls - allocated << " of " << calls << " frames elided (sum " << sum << ")" << std::endl;
+    }
+
+    std::cout << "frame | allocator | ns per frame | million frames/s | mallocs per frame" << std::endl;
+    sameThread("small frame, default new", [](int i) { return example_coroutine<DefaultFrame>(i); });
+    sameThread("small frame, pooled     ", [](int i) { return example_coroutine<framepool::PooledFrame>(i); });
+    sameThread("600 B frame, default new", [](int i) { return large_coroutine<DefaultFrame>(i); });
+    sameThread("600 B frame, pooled     ", [](int i) { return large_coroutine<framepool::PooledFrame>(i); });
+
+    std::cout << "created on one thread, destroyed on another" << std::endl;
+    std::cout << "allocator | ns per frame | million frames/s | mallocs per frame | slabs carved" << std::endl;
+    crossThread("default new", [](int i) { return example_coroutine<DefaultFrame>(i); });
+    crossThread("pooled     ", [](int i) { return example_coroutine<framepool::PooledFrame>(i); });
+    crossThread("pooled     ", [](int i) { return example_coroutine<framepool::PooledFrame>(i); });
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Coroutine result: 42
+HALO: 0 of 1000 frames elided (sum 999000)
+frame | allocator | ns per frame | million frames/s | mallocs per frame
+small frame, default new | 17.0527 | 58.6418 | 1
+small frame, pooled      | 6.8048 | 146.955 | 0
+600 B frame, default new | 17.0895 | 58.5154 | 1
+600 B frame, pooled      | 7.31975 | 136.617 | 0
+created on one thread, destroyed on another
+allocator | ns per frame | million frames/s | mallocs per frame | slabs carved
+default new | 58.1705 | 17.1908 | 1.00154 | 0
+pooled      | 31.7252 | 31.5206 | 0.0010345 | 539
+pooled      | 27.5166 | 36.3417 | 0.0010255 | 42
+GCC 12 has no HALO, so every frame of the CountingFrame coroutine reached operator
+new even though each one lives entirely inside the loop. Clang would be expected to
+elide these, but that was not measured here. With the pooled policy a warm cache
+creates and destroys frames without calling malloc, 2-2.5x faster than the default
+allocator for both frame sizes. When frames are destroyed on another thread, they
+flow back through the owner's remote lists. The first pass carves slabs while the
+consumer thread lags behind on the single core. The second pass mostly reuses
+frames returned by the first, and the only mallocs left are the batch vectors.
+-------------------------------------------------------------*/
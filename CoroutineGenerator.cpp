@@ -0,0 +1,334 @@
+/*----------------------------------------------------------------------------------
+Coroutine generator<T> with ranges integration
+None of the coroutine types in this repo yields a sequence (std::generator only
+arrives with C++23). A generator turns a producer with nested loops and local
+state into a lazy range without writing an iterator class by hand:
+    gen::generator<const Record&> records(const Chunks& chunks) {
+        for (const auto& chunk : chunks)
+            for (const auto& record : chunk) co_yield record;
+    }
+    - co_yield stores only the address of the yielded object; *it refers to the
+      object inside the producer (or to the temporary in the co_yield
+      expression, which lives until the generator is resumed), so nothing is
+      copied. generator<T&> hands out mutable references, generator<T> and
+      generator<const T&> const ones
+    - lazy: the body runs up to the first co_yield when begin() is called, then
+      one step per ++it; the frame is freed when the generator is destroyed,
+      so breaking out of the loop early is fine
+    - it is a move-only view with an input iterator and std::default_sentinel_t,
+      so it composes with std::views::filter/transform/take like the pipelines
+      in C++20.cpp (single pass: iterate it once)
+    - an exception thrown in the body is rethrown from begin() or ++it
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <coroutine>
+#include <ranges>
+#include <iterator>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace gen {
+
+template<typename T>
+class generator : public std::ranges::view_interface<generator<T>> {
+    public:
+        using value_type = std::remove_cvref_t<T>;
+        using reference = std::conditional_t<std::is_reference_v<T>, T, const T&>;
+
+        struct promise_type {
+            std::add_pointer_t<reference> current = nullptr;
+            std::exception_ptr error;
+
+            generator get_return_object() noexcept {
+                return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_always final_suspend() const noexcept { return {}; }
+            std::suspend_always yield_value(reference value) noexcept {
+                current = std::addressof(value);
+                return {};
+            }
+            void return_void() const noexcept {}
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+            // A generator is driven by its consumer; it cannot co_await
+            void await_transform() = delete;
+        };
+
+        class iterator {
+            public:
+                using iterator_concept = std::input_iterator_tag;
+                using value_type = generator::value_type;
+                using difference_type = std::ptrdiff_t;
+
+                iterator() = default;
+                reference operator*() const noexcept { return static_cast<reference>(*m_handle.promise().current); }
+                iterator& operator++() {
+                    m_handle.resume();
+                    rethrow(m_handle);
+                    return *this;
+                }
+                void operator++(int) { ++*this; }
+                friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept { return it.m_handle.done(); }
+            private:
+                friend class generator;
+                explicit iterator(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+                std::coroutine_handle<promise_type> m_handle;
+        };
+
+        generator(generator&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        generator& operator=(generator&& other) noexcept {
+            if (this != &other) {
+                if (m_handle) m_handle.destroy();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+        ~generator() { if (m_handle) m_handle.destroy(); }
+
+        iterator begin() {
+            m_handle.resume();
+            rethrow(m_handle);
+            return iterator(m_handle);
+        }
+        std::default_sentinel_t end() const noexcept { return {}; }
+    private:
+        explicit generator(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+        static void rethrow(std::coroutine_handle<promise_type> handle) {
+            if (handle.done() && handle.promise().error) std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+        }
+        std::coroutine_handle<promise_type> m_handle;
+};
+
+}   // namespace gen
+
+static_assert(std::ranges::input_range<gen::generator<int>>);
+static_assert(std::ranges::view<gen::generator<const std::string&>>);
+
+gen::generator<std::uint64_t> fibonacci() {
+    std::uint64_t a = 0, b = 1;
+    while (true) {
+        co_yield a;
+        a = std::exchange(b, a + b);
+    }
+}
+gen::generator<int> numbers(int first, int last) {
+    for (int n = first; n <= last; ++n) co_yield n;
+}
+gen::generator<std::string&> words(std::vector<std::string>& storage) {
+    for (auto& word : storage) co_yield word;
+}
+gen::generator<int> failing() {
+    co_yield 1;
+    throw std::runtime_error("source went away");
+}
+
+// Benchmark data: records spread over chunks of uneven size (some empty), like
+// pages read from a file. Copies of a Record are counted.
+static std::size_t g_copies = 0;
+struct Record {
+    std::uint64_t id = 0;
+    double value = 0;
+    char payload[48] = {};
+
+    Record() = default;
+    Record(std::uint64_t i, double v) : id(i), value(v) {}
+    Record(const Record& other) : id(other.id), value(other.value) {
+        std::copy(std::begin(other.payload), std::end(other.payload), payload);
+        ++g_copies;
+    }
+    Record& operator=(const Record&) = default;
+};
+using Chunks = std::vector<std::vector<Record>>;
+
+gen::generator<const Record&> records(const Chunks& chunks) {
+    for (const auto& chunk : chunks) {
+        for (const auto& record : chunk) co_yield record;
+    }
+}
+
+template<typename F>
+void for_each_record(const Chunks& chunks, F&& f) {
+    for (const auto& chunk : chunks) {
+        for (const auto& record : chunk) f(record);
+    }
+}
+void for_each_record_function(const Chunks& chunks, const std::function<void(const Record&)>& f) {
+    for (const auto& chunk : chunks) {
+        for (const auto& record : chunk) f(record);
+    }
+}
+
+// What records() replaces: the loop state spelled out as an iterator
+class RecordIterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = Record;
+        using difference_type = std::ptrdiff_t;
+
+        RecordIterator() = default;
+        explicit RecordIterator(const Chunks& chunks) : m_chunks(&chunks) { skipEmpty(); }
+        const Record& operator*() const { return (*m_chunks)[m_chunk][m_index]; }
+        RecordIterator& operator++() {
+            if (++m_index == (*m_chunks)[m_chunk].size()) {
+                ++m_chunk;
+                m_index = 0;
+                skipEmpty();
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        friend bool operator==(const RecordIterator& it, std::default_sentinel_t) { return it.m_chunk == it.m_chunks->size(); }
+    private:
+        void skipEmpty() {
+            while (m_chunk < m_chunks->size() && (*m_chunks)[m_chunk].empty()) ++m_chunk;
+        }
+        const Chunks* m_chunks = nullptr;
+        std::size_t m_chunk = 0, m_index = 0;
+};
+struct RecordRange : std::ranges::view_interface<RecordRange> {
+    const Chunks* chunks;
+    RecordIterator begin() const { return RecordIterator(*chunks); }
+    std::default_sentinel_t end() const { return {}; }
+};
+
+static bool selected(const Record& r) { return (r.id & 3) != 0; }
+static double weight(const Record& r) { return r.value * 0.5; }
+
+template<typename Run>
+void measure(const char* name, std::size_t elements, Run run) {
+    constexpr int rounds = 5;
+    double sum = run();   // warm up
+    const auto copies = g_copies;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) sum += run();
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << " | " << ns / (rounds * elements) << " | " << (g_copies - copies) << " | " << sum << std::endl;
+}
+
+int main() {
+    std::cout << "Fibonacci:";
+    for (auto n : fibonacci() | std::views::take(10)) std::cout << " " << n;
+    std::cout << std::endl;
+
+    // The pipeline from C++20.cpp, fed by a generator instead of a vector
+    auto result = numbers(1, 5) | std::views::filter([](int n) {
+        return n % 2 == 0;
+    }) | std::views::transform([](int n) {
+        return n * n;
+    });
+    for (int n : result) {
+        std::cout << n << " ";  // Output: 4 16
+    }
+    std::cout << std::endl;
+
+    std::vector<std::string> storage{"lazy", "coroutine", "generator"};
+    for (std::string& word : words(storage)) {
+        std::cout << word << (&word == &storage.front() ? " (same object as in storage)" : "") << std::endl;
+        word += "!";   // yielded by reference: changes the stored string
+    }
+    std::cout << storage[0] << " " << storage[1] << " " << storage[2] << std::endl;
+
+    try {
+        for (int n : failing()) std::cout << "got " << n << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Caught exception: " << e.what() << std::endl;
+    }
+
+    // 4M records of 64 bytes in chunks of 0..2000
+    Chunks chunks;
+    std::mt19937 rng(11);
+    std::size_t total = 0;
+    for (std::uint64_t id = 0; total < 4'000'000;) {
+        auto& chunk = chunks.emplace_back();
+        const std::size_t size = rng() % 2001;
+        chunk.reserve(size);
+        for (std::size_t i = 0; i < size; ++i, ++id) chunk.emplace_back(id, static_cast<double>(rng() % 1000));
+        total += size;
+    }
+    std::cout << total << " records in " << chunks.size() << " chunks; sum of value/2 over records with id % 4 != 0" << std::endl;
+    std::cout << "approach | ns per record | Record copies | result" << std::endl;
+    measure("nested loops", total, [&] {
+        double sum = 0;
+        for (const auto& chunk : chunks) {
+            for (const auto& r : chunk) if (selected(r)) sum += weight(r);
+        }
+        return sum;
+    });
+    measure("callback (template)", total, [&] {
+        double sum = 0;
+        for_each_record(chunks, [&sum](const Record& r) { if (selected(r)) sum += weight(r); });
+        return sum;
+    });
+    measure("callback (std::function)", total, [&] {
+        double sum = 0;
+        for_each_record_function(chunks, [&sum](const Record& r) { if (selected(r)) sum += weight(r); });
+        return sum;
+    });
+    measure("hand-written iterator", total, [&] {
+        double sum = 0;
+        for (const Record& r : RecordRange{{}, &chunks}) if (selected(r)) sum += weight(r);
+        return sum;
+    });
+    measure("generator", total, [&] {
+        double sum = 0;
+        for (const Record& r : records(chunks)) if (selected(r)) sum += weight(r);
+        return sum;
+    });
+    measure("generator | filter | transform", total, [&] {
+        double sum = 0;
+        for (double w : records(chunks) | std::views::filter(selected) | std::views::transform(weight)) sum += w;
+        return sum;
+    });
+    measure("generator, body copies each record", total, [&] {
+        // For contrast: the body makes a copy per element. The generator type is not
+        // the cause: generator<Record> hands the copy out by const reference too
+        auto copies = [](const Chunks& chunks) -> gen::generator<Record> {
+            for (const auto& chunk : chunks) {
+                for (const auto& record : chunk) co_yield Record(record);
+            }
+        };
+        double sum = 0;
+        for (const Record& r : copies(chunks)) if (selected(r)) sum += weight(r);
+        return sum;
+    });
+    return 0;
+}
+
+/*------------- Output (1 core sandbox) -----------------------
+Fibonacci: 0 1 1 2 3 5 8 13 21 34
+4 16 
+lazy (same object as in storage)
+coroutine
+generator
+lazy! coroutine! generator!
+got 1
+Caught exception: source went away
+4000131 records in 4002 chunks; sum of value/2 over records with id % 4 != 0
+approach | ns per record | Record copies | result
+nested loops | 7.20501 | 0 | 4.49732e+09
+callback (template) | 8.05786 | 0 | 4.49732e+09
+callback (std::function) | 10.2989 | 0 | 4.49732e+09
+hand-written iterator | 9.78809 | 0 | 4.49732e+09
+generator | 11.1414 | 0 | 4.49732e+09
+generator | filter | transform | 12.5326 | 0 | 4.49732e+09
+generator, body copies each record | 13.5101 | 20000655 | 4.49732e+09
+
+Each round streams 256 MB of records, so memory traffic makes up most of the
+7 ns baseline. The generator adds about 4 ns per element over the nested loops
+(a resume and a suspend, which GCC does not inline) and about 1.5 ns over the
+hand-written iterator; the ranges pipeline on top costs about 1.5 ns more.
+No generator row copies a Record, because co_yield passes the yielded object by
+reference. The last row copies once per element (20M over the 5 timed rounds)
+only because its body yields a freshly made copy, Record(record).
+-------------------------------------------------------------*/
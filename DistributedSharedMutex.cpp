@@ -0,0 +1,245 @@
+/*----------------------------------------------------------------------------------
+Scalable reader-writer lock with per-thread reader indicators
+std::shared_mutex keeps the reader count in one word. Every lock_shared() and
+unlock_shared() is an atomic read-modify-write on that word, so with many readers
+the cache line holding it bounces between all cores even though nobody writes.
+DistributedSharedMutex spreads the reader indicator over one cache-line sized
+slot per thread (in the spirit of BRAVO and distributed counters):
+    - a reader only touches its own slot and reads the shared writer flag
+    - a writer takes a writer mutex, raises the flag and waits until every
+      reader slot drains to zero
+Preference::Writer (default) makes new readers back off as soon as a writer is
+pending. To protect readers from starvation, after MaxWriterStreak consecutive
+writers that overtook waiting readers, the next writer first lets them in.
+Preference::Reader lets a writer wait for queued readers, bounded by a spin budget
+so writers cannot starve either.
+It meets the SharedMutex requirements, so std::shared_lock and std::unique_lock
+work with it and Resource below is the same class as in
+"std::shared_lock, std::unique_lock.cpp", only templated on the mutex type.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <string>
+#include <shared_mutex>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <array>
+#include <algorithm>
+
+enum class Preference { Writer, Reader };
+
+template<Preference Pref = Preference::Writer>
+class DistributedSharedMutex {
+    public:
+        static constexpr std::size_t MaxThreads = 256;
+        static constexpr int MaxWriterStreak = 8;
+        static constexpr int StarvationSpins = 1000;
+        static constexpr std::size_t SharedSlot = MaxThreads;
+
+        void lock_shared() {
+            auto& slot = m_slots[thread_slot_index()].readers;
+            for (;;) {
+                if (m_writer.load(std::memory_order_acquire) == 0) {
+                    // Dekker-style handshake with the writer: publish, then re-check
+                    slot.fetch_add(1, std::memory_order_seq_cst);
+                    if (m_writer.load(std::memory_order_seq_cst) == 0) {
+                        return;
+                    }
+                    slot.fetch_sub(1, std::memory_order_release);
+                }
+                m_waitingReaders.fetch_add(1, std::memory_order_relaxed);
+                while (m_writer.load(std::memory_order_acquire) != 0) {
+                    std::this_thread::yield();
+                }
+                m_waitingReaders.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        bool try_lock_shared() {
+            auto& slot = m_slots[thread_slot_index()].readers;
+            if (m_writer.load(std::memory_order_acquire) != 0) {
+                return false;
+            }
+            slot.fetch_add(1, std::memory_order_seq_cst);
+            if (m_writer.load(std::memory_order_seq_cst) == 0) {
+                return true;
+            }
+            slot.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+        void unlock_shared() {
+            m_slots[thread_slot_index()].readers.fetch_sub(1, std::memory_order_release);
+        }
+
+        void lock() {
+            m_writerMutex.lock();
+            if (mustYieldToReaders()) {
+                for (int spins = 0; spins < StarvationSpins &&
+                        m_waitingReaders.load(std::memory_order_relaxed) > 0; ++spins) {
+                    std::this_thread::yield();
+                }
+                m_streak = 0;
+            }
+            m_writer.store(1, std::memory_order_seq_cst);
+            drainReaders();
+            m_streak = m_waitingReaders.load(std::memory_order_relaxed) > 0 ? m_streak + 1 : 0;
+        }
+        bool try_lock() {
+            if (!m_writerMutex.try_lock()) {
+                return false;
+            }
+            m_writer.store(1, std::memory_order_seq_cst);
+            for (const auto& s : m_slots) {
+                if (s.readers.load(std::memory_order_seq_cst) != 0) {
+                    m_writer.store(0, std::memory_order_release);
+                    m_writerMutex.unlock();
+                    return false;
+                }
+            }
+            return true;
+        }
+        void unlock() {
+            m_writer.store(0, std::memory_order_release);
+            m_writerMutex.unlock();
+        }
+    private:
+        bool mustYieldToReaders() const {
+            if constexpr (Pref == Preference::Reader) {
+                return true;
+            } else {
+                return m_streak >= MaxWriterStreak;
+            }
+        }
+        // Writer half of the handshake in lock_shared(): the flag store in lock() and
+        // every load here are seq_cst, so a reader whose re-check missed the flag has
+        // its slot registration and increment ordered before this scan. An acquire
+        // load of s_highWater could be satisfied before the flag store and miss a
+        // slot registered just before it
+        void drainReaders() {
+            const auto high = std::min(s_highWater.load(std::memory_order_seq_cst), SharedSlot + 1);
+            for (std::size_t i = 0; i < high; ++i) {
+                while (m_slots[i].readers.load(std::memory_order_seq_cst) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        // Reader slot per live thread, recycled when the thread exits. Readers past
+        // MaxThreads share one overflow slot: a slot is only a reader count, so
+        // sharing it stays correct and just brings back the contention of a single
+        // counter for those threads. Claiming also raises s_highWater so that
+        // drainReaders() scans the slot
+        static std::size_t thread_slot_index() {
+            static std::array<std::atomic<bool>, MaxThreads> used{};
+            struct Claim {
+                std::size_t index = SharedSlot;
+                Claim() {
+                    for (std::size_t i = 0; i < MaxThreads; ++i) {
+                        bool expected = false;
+                        if (used[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                            index = i;
+                            break;
+                        }
+                    }
+                    auto high = s_highWater.load(std::memory_order_seq_cst);
+                    while (high <= index && !s_highWater.compare_exchange_weak(high, index + 1, std::memory_order_seq_cst)) {}
+                }
+                ~Claim() { if (index != SharedSlot) used[index].store(false, std::memory_order_release); }
+            };
+            thread_local Claim claim;
+            return claim.index;
+        }
+    private:
+        struct alignas(64) Slot {
+            std::atomic<std::uint32_t> readers{0};
+        };
+        inline static std::atomic<std::size_t> s_highWater{0};
+        alignas(64) std::atomic<int> m_writer{0};
+        alignas(64) std::atomic<int> m_waitingReaders{0};
+        std::mutex m_writerMutex;
+        int m_streak = 0;   // only touched while holding m_writerMutex
+        std::array<Slot, MaxThreads + 1> m_slots;   // the last one is SharedSlot
+};
+
+template<typename SharedMutex = std::shared_mutex>
+class Resource {
+    public:
+        std::string read() const {
+            auto lock = std::shared_lock{mutex};
+            return m_data;
+        }
+        void write(std::string_view data) {
+            auto lock = std::unique_lock{mutex};
+            m_data = data;
+        }
+    private:
+        std::string m_data{"undefined"};
+        mutable SharedMutex mutex;
+};
+
+// Every thread does 99% reads and 1% writes for a fixed time; returns ops/s
+template<typename R>
+double ops_per_second(R& resource, int threads) {
+    constexpr auto duration = std::chrono::milliseconds(100);
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> total{0};
+    {
+        std::vector<std::jthread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::uint64_t ops = 0;
+                const auto payload = "Write: " + std::to_string(t);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    if (ops % 100 == 99) resource.write(payload);
+                    else resource.read();
+                    ++ops;
+                }
+                total.fetch_add(ops);
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    }
+    return static_cast<double>(total.load()) / std::chrono::duration<double>(duration).count();
+}
+
+int main() {
+    auto resource = Resource<DistributedSharedMutex<>>();
+    auto reader = [&resource]() {
+        for(int i = 0; i < 3; i++) {
+            auto data = resource.read();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    };
+    {
+        auto readers = std::vector<std::jthread>{};
+        for(int i=0; i<4; i++) {
+            readers.push_back(std::jthread(reader));
+        }
+        resource.write("Write: 0");
+    }
+    std::cout << "Final value: " << resource.read() << std::endl;
+
+    std::cout << "threads | std::shared_mutex ops/s | distributed (writer pref) ops/s | distributed (reader pref) ops/s" << std::endl;
+    for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+        Resource<std::shared_mutex> baseline;
+        Resource<DistributedSharedMutex<Preference::Writer>> writerPref;
+        Resource<DistributedSharedMutex<Preference::Reader>> readerPref;
+        std::cout << threads << " | " << ops_per_second(baseline, threads)
+                  << " | " << ops_per_second(writerPref, threads)
+                  << " | " << ops_per_second(readerPref, threads) << std::endl;
+    }
+    return 0;
+}
+
+/*------------- Output (1 core sandbox) -----------------------
+Final value: Write: 0
+threads | std::shared_mutex ops/s | distributed (writer pref) ops/s | distributed (reader pref) ops/s
+1 | 3.41488e+07 | 3.98066e+07 | 4.27717e+07
+2 | 3.90003e+07 | 3.93562e+07 | 4.78998e+07
+4 | 3.58194e+07 | 4.0425e+07 | 4.14106e+07
+8 | 4.03285e+07 | 4.70129e+07 | 4.5088e+07
+16 | 3.71368e+07 | 4.56313e+07 | 4.78764e+07
+32 | 4.10218e+07 | 4.87602e+07 | 4.3564e+07
+64 | 3.59938e+07 | 4.45325e+07 | 4.27637e+07
+-------------------------------------------------------------*/
@@ -0,0 +1,364 @@
+/*----------------------------------------------------------------------------------
+Event-loop coroutine scheduler
+simple_awaiter in Coroutines.cpp starts a detached std::thread for every co_await,
+so each suspended coroutine costs a whole OS thread (stack, kernel task, creation
+time), and the thread reads 'delay' through the awaiter's 'this', which belongs to
+a temporary that is gone once the coroutine is suspended.
+loop::EventLoop runs coroutines on the thread that calls run(), without creating
+any threads:
+    - loop.spawn(task) queues a loop::Task (a fire-and-forget coroutine, started
+      lazily, frame freed when it finishes); run() returns once all have finished
+    - co_await loop.sleep_for(d) / sleep_until(t) puts the coroutine into a timer
+      heap ordered by deadline; the loop sleeps until the earliest one is due
+    - co_await loop.yield() goes to the back of the ready queue
+    - loop::Event is awaited on the loop and set() from any thread: the waiting
+      coroutine is posted back to the loop (mutex-protected inbox + condition
+      variable) and resumed there, never on the setting thread
+One EventLoop per thread gives a per-core layout; a coroutine stays on its loop.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <coroutine>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <latch>
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include <functional>
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <unistd.h>
+
+namespace loop {
+
+using Clock = std::chrono::steady_clock;
+
+class EventLoop;
+
+class Task {
+    public:
+        struct promise_type {
+            EventLoop* loop = nullptr;
+
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            struct Final {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+                void await_resume() const noexcept {}
+            };
+            Final final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception();
+        };
+
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task& operator=(Task&&) = delete;
+        // A task that was never spawned is destroyed without running
+        ~Task() { if (m_handle) m_handle.destroy(); }
+    private:
+        friend class EventLoop;
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+        std::coroutine_handle<promise_type> m_handle;
+};
+
+class EventLoop {
+    public:
+        EventLoop() = default;
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator=(const EventLoop&) = delete;
+
+        // Loop thread only
+        void spawn(Task task) {
+            auto handle = std::exchange(task.m_handle, nullptr);
+            handle.promise().loop = this;
+            ++m_live;
+            m_ready.push_back(handle);
+        }
+        // Runs until every spawned task has finished; rethrows the first exception
+        // that escaped a task
+        void run() {
+            while (m_live > 0) {
+                while (!m_ready.empty()) {
+                    auto handle = m_ready.front();
+                    m_ready.pop_front();
+                    handle.resume();
+                }
+                if (m_error) std::rethrow_exception(std::exchange(m_error, nullptr));
+                fireTimers();
+                if (!m_ready.empty() || m_live == 0) continue;
+                std::unique_lock lock(m_mutex);
+                if (m_inbox.empty()) {
+                    if (!m_timers.empty()) {
+                        m_cv.wait_until(lock, m_timers.top().when);
+                    } else {
+                        m_cv.wait(lock, [this] { return !m_inbox.empty(); });
+                    }
+                }
+                for (auto handle : m_inbox) m_ready.push_back(handle);
+                m_inbox.clear();
+            }
+        }
+        // Any thread: resume 'handle' on the loop
+        void post(std::coroutine_handle<> handle) {
+            {
+                std::lock_guard lock(m_mutex);
+                m_inbox.push_back(handle);
+            }
+            m_cv.notify_one();
+        }
+
+        struct SleepAwaiter {
+            EventLoop* loop;
+            Clock::time_point when;
+            bool await_ready() const { return when <= Clock::now(); }
+            void await_suspend(std::coroutine_handle<> handle) const {
+                loop->m_timers.push({when, loop->m_timerSeq++, handle});
+            }
+            void await_resume() const noexcept {}
+        };
+        SleepAwaiter sleep_until(Clock::time_point when) { return {this, when}; }
+        template<typename Rep, typename Period>
+        SleepAwaiter sleep_for(std::chrono::duration<Rep, Period> d) {
+            return {this, Clock::now() + std::chrono::duration_cast<Clock::duration>(d)};
+        }
+
+        struct YieldAwaiter {
+            EventLoop* loop;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) const { loop->m_ready.push_back(handle); }
+            void await_resume() const noexcept {}
+        };
+        YieldAwaiter yield() { return {this}; }
+
+        std::size_t pendingTimers() const { return m_timers.size(); }
+    private:
+        friend struct Task::promise_type;
+
+        struct Timer {
+            Clock::time_point when;
+            std::uint64_t seq;   // equal deadlines resume in the order they were armed
+            std::coroutine_handle<> handle;
+            bool operator>(const Timer& other) const {
+                return when != other.when ? when > other.when : seq > other.seq;
+            }
+        };
+        // Due timers resume right away, earliest first
+        void fireTimers() {
+            if (m_timers.empty()) return;
+            const auto now = Clock::now();
+            while (!m_timers.empty() && m_timers.top().when <= now) {
+                auto handle = m_timers.top().handle;
+                m_timers.pop();
+                handle.resume();
+            }
+        }
+
+        std::deque<std::coroutine_handle<>> m_ready;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<>> m_timers;
+        std::uint64_t m_timerSeq = 0;
+        std::size_t m_live = 0;
+        std::exception_ptr m_error;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<std::coroutine_handle<>> m_inbox;
+};
+
+inline void Task::promise_type::Final::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    auto* loop = handle.promise().loop;
+    handle.destroy();
+    --loop->m_live;
+}
+inline void Task::promise_type::unhandled_exception() {
+    if (!loop->m_error) loop->m_error = std::current_exception();
+}
+
+// One waiter, set() from any thread; the waiter resumes on its loop
+class Event {
+    public:
+        explicit Event(EventLoop& loop) : m_loop(loop) {}
+        void set() {
+            void* waiter = m_state.exchange(this, std::memory_order_acq_rel);
+            if (waiter != nullptr && waiter != this) m_loop.post(std::coroutine_handle<>::from_address(waiter));
+        }
+        auto operator co_await() {
+            struct Awaiter {
+                Event& event;
+                bool await_ready() const { return event.m_state.load(std::memory_order_acquire) == &event; }
+                bool await_suspend(std::coroutine_handle<> handle) const {
+                    void* expected = nullptr;
+                    // false: set() won the race, continue without suspending
+                    return event.m_state.compare_exchange_strong(expected, handle.address(), std::memory_order_acq_rel);
+                }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{*this};
+        }
+    private:
+        EventLoop& m_loop;
+        std::atomic<void*> m_state{nullptr};   // nullptr, a waiting handle, or this (set)
+};
+
+}   // namespace loop
+
+// Heap accounting for the benchmark
+static std::atomic<std::size_t> g_heapBytes{0};
+void* operator new(std::size_t size) {
+    g_heapBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t size) noexcept {
+    g_heapBytes.fetch_sub(size, std::memory_order_relaxed);
+    std::free(p);
+}
+
+static double rssMiB() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1 << 20);
+}
+
+loop::Task async_wait(loop::EventLoop& loop, std::chrono::milliseconds delay) {
+    std::cout << "Coroutine is about to be suspended...\n";
+    co_await loop.sleep_for(delay);
+    std::cout << "Coroutine has been resumed\n";
+}
+loop::Task ticker(loop::EventLoop& loop, const char* name, int ticks) {
+    for (int i = 0; i < ticks; ++i) {
+        std::cout << name << " " << i << "\n";
+        co_await loop.yield();
+    }
+}
+int compute_square(int x) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Simulate Heavy Computation
+    return x * x;
+}
+loop::Task await_worker(loop::Event& done, const int& result, std::thread::id loopThread) {
+    co_await done;
+    std::cout << "Worker result " << result << ", resumed on the loop thread: " << std::boolalpha
+              << (std::this_thread::get_id() == loopThread) << "\n";
+}
+
+struct Lateness {
+    double p50, p99, max;
+};
+static Lateness summarize(std::vector<float>& lateUs) {
+    std::sort(lateUs.begin(), lateUs.end());
+    return {lateUs[lateUs.size() / 2], lateUs[lateUs.size() * 99 / 100], lateUs.back()};
+}
+
+loop::Task sleeper(loop::EventLoop& loop, loop::Clock::time_point when, float& lateUs) {
+    co_await loop.sleep_until(when);
+    lateUs = std::chrono::duration<float, std::micro>(loop::Clock::now() - when).count();
+}
+
+int main() {
+    using namespace std::chrono_literals;
+    {
+        std::cout << "Main start" << std::endl;
+        loop::EventLoop loop;
+        loop.spawn(async_wait(loop, 200ms));
+        loop.spawn(ticker(loop, "ping", 3));
+        loop.spawn(ticker(loop, "pong", 3));
+        loop::Event done(loop);
+        int result = 0;
+        std::jthread worker([&done, &result] {
+            result = compute_square(10);
+            done.set();
+        });
+        loop.spawn(await_worker(done, result, std::this_thread::get_id()));
+        std::cout << "Main runs the loop while coroutines are suspended\n";
+        loop.run();
+        std::cout << "All coroutines finished" << std::endl;
+    }
+
+    constexpr int sleepers = 100'000;
+    constexpr int threadSleepers = 2'000;   // one OS thread each, as in Coroutines.cpp
+    constexpr auto spread = 1000ms;
+    std::cout << sleepers << " coroutines sleeping 1..1000 ms on one loop thread vs "
+              << threadSleepers << " thread-per-await sleepers" << std::endl;
+    std::cout << "approach | sleepers | heap bytes each | RSS MiB | late p50 us | p99 us | max us" << std::endl;
+    std::srand(42);
+    std::vector<std::chrono::microseconds> delays(sleepers);
+    for (auto& d : delays) d = std::chrono::microseconds(1000 + std::rand() % (spread.count() * 1000 - 1000));
+    {
+        loop::EventLoop loop;
+        std::vector<float> lateUs(sleepers);
+        const double rssBefore = rssMiB();
+        const std::size_t heapBefore = g_heapBytes.load();
+        // Deadlines start after the set-up, so every coroutine is parked first
+        const auto start = loop::Clock::now() + 50ms;
+        for (int i = 0; i < sleepers; ++i) loop.spawn(sleeper(loop, start + delays[i], lateUs[i]));
+        // Run the first step of every coroutine so all of them are parked on timers
+        double heapEach = 0, rss = 0;
+        loop.spawn([](loop::EventLoop& loop, double& heapEach, double& rss, std::size_t heapBefore, double rssBefore) -> loop::Task {
+            co_await loop.yield();
+            heapEach = static_cast<double>(g_heapBytes.load() - heapBefore) / sleepers;
+            rss = rssMiB() - rssBefore;
+            std::cout << "  (" << loop.pendingTimers() << " coroutines parked on the timer heap)\n";
+        }(loop, heapEach, rss, heapBefore, rssBefore));
+        loop.run();
+        const auto l = summarize(lateUs);
+        std::cout << "event loop | " << sleepers << " | " << heapEach << " | " << rss << " | "
+                  << l.p50 << " | " << l.p99 << " | " << l.max << std::endl;
+    }
+    {
+        std::vector<float> lateUs(threadSleepers);
+        std::latch parked(threadSleepers), finished(threadSleepers);
+        const double rssBefore = rssMiB();
+        const auto start = loop::Clock::now() + 50ms;
+        for (int i = 0; i < threadSleepers; ++i) {
+            const auto when = start + delays[i];
+            std::thread([when, &lateUs, &parked, &finished, i] {
+                parked.count_down();
+                std::this_thread::sleep_until(when);
+                lateUs[i] = std::chrono::duration<float, std::micro>(loop::Clock::now() - when).count();
+                finished.count_down();
+            }).detach();
+        }
+        parked.wait();
+        const double rss = rssMiB() - rssBefore;
+        finished.wait();
+        std::this_thread::sleep_for(50ms);   // let the detached threads exit
+        const auto l = summarize(lateUs);
+        std::cout << "thread per await | " << threadSleepers << " | n/a | " << rss << " | "
+                  << l.p50 << " | " << l.p99 << " | " << l.max << std::endl;
+    }
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Main start
+Main runs the loop while coroutines are suspended
+Coroutine is about to be suspended...
+ping 0
+pong 0
+ping 1
+pong 1
+ping 2
+pong 2
+Worker result 100, resumed on the loop thread: true
+Coroutine has been resumed
+All coroutines finished
+100000 coroutines sleeping 1..1000 ms on one loop thread vs 2000 thread-per-await sleepers
+approach | sleepers | heap bytes each | RSS MiB | late p50 us | p99 us | max us
+  (100000 coroutines parked on the timer heap)
+event loop | 100000 | 127.662 | 13.8945 | 35.584 | 61.209 | 1497.53
+thread per await | 2000 | n/a | 15.6797 | 66.059 | 270.08 | 1614.56
+A parked coroutine costs about 128 heap bytes: its frame, its timer heap entry and
+its ready-queue slot. 100k of them fit in 14 MiB on one thread. The thread-per-await
+version uses more RSS for 2,000 sleepers (50x fewer) than the loop does for 100k,
+and that figure leaves out each thread's kernel stack and 8 MiB of reserved stack
+address space. Lateness is how long after its deadline a sleeper resumed. The loop
+wakes within tens of microseconds, limited by condition_variable::wait_until;
+2,000 threads waking on one core queue up behind each other.
+-------------------------------------------------------------*/
@@ -0,0 +1,276 @@
+/*----------------------------------------------------------------------------------
+Flat combining decorator
+With MultiThreadedAnimalProxy (DecoratorWrapper.cpp) every call pays its own lock
+handoff: the mutex cache line and the wrapped object move to a new core for every
+single operation. Flat combining batches them instead:
+    - each thread owns a cache-line sized publication slot and posts its operation
+      there (a function pointer plus a pointer to the caller's lambda)
+    - the thread that wins the combiner lock scans all slots and executes every
+      pending operation in one pass, while the object stays hot in its cache
+    - the other threads just spin on their own slot until it is marked done, or
+      become the combiner themselves when the lock is released
+Operations never allocate: the lambda lives on the caller's stack, which is safe
+because the caller does not return before its slot is completed. An exception
+thrown by an operation is stored in its slot and rethrown in the posting thread;
+the combiner carries on with the other slots. Threads beyond MaxThreads get no
+slot and run their operation under the combiner lock directly.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+template<typename T>
+class FlatCombiner {
+    public:
+        static constexpr std::size_t MaxThreads = 256;
+
+        template<typename... Args>
+        explicit FlatCombiner(Args&&... args) : m_value(std::forward<Args>(args)...) {}
+
+        // Runs f(value) under the combiner, possibly on another thread
+        template<typename F>
+        auto apply(F&& f) {
+            using R = std::invoke_result_t<F&, T&>;
+            if constexpr (std::is_void_v<R>) {
+                post(f);
+            } else {
+                std::optional<R> result;
+                auto call = [&](T& value) { result.emplace(f(value)); };
+                post(call);
+                return std::move(*result);
+            }
+        }
+        // Average number of operations executed per combining pass
+        double averageBatch() const {
+            const auto passes = m_passes.load(std::memory_order_relaxed);
+            return passes ? static_cast<double>(m_combined.load(std::memory_order_relaxed)) / passes : 0.0;
+        }
+    private:
+        struct alignas(64) Slot {
+            void (*fn)(T&, void*) = nullptr;
+            void* ctx = nullptr;
+            std::exception_ptr error;   // set by the combiner, read by the owner after pending clears
+            std::atomic<bool> pending{false};
+        };
+        struct CombinerRelease {
+            std::atomic<bool>& combining;
+            ~CombinerRelease() { combining.store(false, std::memory_order_release); }
+        };
+
+        static constexpr std::size_t NoSlot = MaxThreads;
+
+        template<typename F>
+        void post(F& f) {
+            const auto index = thread_slot_index();
+            if (index == NoSlot) {
+                // No publication slot: run f as the combiner, then serve the others
+                int spins = 0;
+                while (m_combining.load(std::memory_order_relaxed) ||
+                       m_combining.exchange(true, std::memory_order_acquire)) {
+                    if (++spins > 64) std::this_thread::yield();
+                }
+                CombinerRelease release{m_combining};
+                f(m_value);
+                combine();
+                return;
+            }
+            auto& slot = m_slots[index];
+            slot.fn = [](T& value, void* ctx) { (*static_cast<F*>(ctx))(value); };
+            slot.ctx = &f;
+            auto high = m_highWater.load(std::memory_order_relaxed);
+            while (high <= index && !m_highWater.compare_exchange_weak(high, index + 1, std::memory_order_relaxed)) {}
+            slot.pending.store(true, std::memory_order_release);
+
+            int spins = 0;
+            while (slot.pending.load(std::memory_order_acquire)) {
+                if (!m_combining.load(std::memory_order_relaxed) &&
+                    !m_combining.exchange(true, std::memory_order_acquire)) {
+                    CombinerRelease release{m_combining};
+                    combine();
+                } else if (++spins > 64) {
+                    std::this_thread::yield();
+                }
+            }
+            if (slot.error) std::rethrow_exception(std::exchange(slot.error, nullptr));
+        }
+        void combine() {
+            std::size_t executed = 0;
+            const auto high = m_highWater.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < high; ++i) {
+                auto& slot = m_slots[i];
+                if (slot.pending.load(std::memory_order_acquire)) {
+                    try {
+                        slot.fn(m_value, slot.ctx);
+                    } catch (...) {
+                        slot.error = std::current_exception();
+                    }
+                    slot.pending.store(false, std::memory_order_release);
+                    ++executed;
+                }
+            }
+            if (executed) {
+                m_passes.fetch_add(1, std::memory_order_relaxed);
+                m_combined.fetch_add(executed, std::memory_order_relaxed);
+            }
+        }
+        // Publication slot per live thread, recycled when the thread exits. Once all
+        // MaxThreads slots are taken a new thread gets NoSlot for its lifetime and
+        // post() serves it by taking the combiner lock itself
+        static std::size_t thread_slot_index() {
+            static std::array<std::atomic<bool>, MaxThreads> used{};
+            struct Claim {
+                std::size_t index = NoSlot;
+                Claim() {
+                    for (std::size_t i = 0; i < MaxThreads; ++i) {
+                        bool expected = false;
+                        if (used[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                            index = i;
+                            return;
+                        }
+                    }
+                }
+                ~Claim() { if (index != NoSlot) used[index].store(false, std::memory_order_release); }
+            };
+            thread_local Claim claim;
+            return claim.index;
+        }
+    private:
+        T m_value;
+        alignas(64) std::atomic<bool> m_combining{false};
+        std::atomic<std::size_t> m_highWater{0};
+        std::atomic<std::uint64_t> m_passes{0};
+        std::atomic<std::uint64_t> m_combined{0};
+        std::array<Slot, MaxThreads> m_slots;
+};
+
+// Abstract Interface to inherit
+class AnimalWithName {
+    public:
+        virtual ~AnimalWithName() = default;
+    public:
+        virtual void setName(const std::string& name) = 0;
+        virtual std::string getName() const = 0;
+};
+// Implementation without protection against concurrency
+class DogWithName : public AnimalWithName {
+    public:
+        void setName(const std::string& name) override {
+            m_name = name;
+        }
+        std::string getName() const override {
+            return "Dog_" + m_name;
+        }
+    private:
+        std::string m_name;
+};
+// Baseline from DecoratorWrapper.cpp
+class MultiThreadedAnimalProxy : public AnimalWithName {
+    public:
+        MultiThreadedAnimalProxy(std::unique_ptr<AnimalWithName> animal) : m_animal(std::move(animal))
+        {}
+    public:
+        void setName(const std::string& name) override {
+            auto lock = std::lock_guard {m_mutex};
+            m_animal->setName(name);
+        }
+        std::string getName() const override {
+            auto lock = std::lock_guard {m_mutex};
+            return m_animal->getName();
+        }
+    private:
+        std::unique_ptr<AnimalWithName> m_animal;
+        mutable std::mutex m_mutex;
+};
+// Same interface, calls are batched by whichever thread is combining
+class FlatCombiningAnimalProxy : public AnimalWithName {
+    public:
+        FlatCombiningAnimalProxy(std::unique_ptr<AnimalWithName> animal) : m_animal(std::move(animal))
+        {}
+    public:
+        void setName(const std::string& name) override {
+            m_animal.apply([&](auto& animal) { animal->setName(name); });
+        }
+        std::string getName() const override {
+            return m_animal.apply([](auto& animal) { return animal->getName(); });
+        }
+        double averageBatch() const { return m_animal.averageBatch(); }
+    private:
+        mutable FlatCombiner<std::unique_ptr<AnimalWithName>> m_animal;
+};
+
+// Splits a fixed number of calls (10% writes) across `threads` threads
+double run_ms(AnimalWithName& animal, int threads) {
+    constexpr int totalOps = 400'000;
+    const int perThread = totalOps / threads;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&animal, perThread, t] {
+                for (int i = 0; i < perThread; ++i) {
+                    if (i % 10 == 0) animal.setName("Rex" + std::to_string(t));
+                    else animal.getName();
+                }
+            });
+        }
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    FlatCombiningAnimalProxy animal(std::make_unique<DogWithName>());
+    auto th = std::thread([&animal](){
+        auto name = animal.getName();
+        std::cout << "The name: " << name << std::endl;
+    });
+    animal.setName("Harry");
+    th.join();
+    std::cout << "After write: " << animal.getName() << std::endl;
+
+    // A throwing operation fails only its own caller; the combiner keeps working
+    FlatCombiner<std::vector<int>> values;
+    try {
+        values.apply([](auto& v) { return v.at(3); });
+    } catch (const std::out_of_range& e) {
+        std::cout << "Caught exception: " << e.what() << std::endl;
+    }
+    values.apply([](auto& v) { v.push_back(7); });
+    std::cout << "Still usable, size " << values.apply([](auto& v) { return v.size(); }) << std::endl;
+
+    std::cout << "threads | mutex ms | flat combining ms | avg batch" << std::endl;
+    for (int threads : {2, 4, 8, 16, 32, 64}) {
+        MultiThreadedAnimalProxy mutexProxy(std::make_unique<DogWithName>());
+        FlatCombiningAnimalProxy fcProxy(std::make_unique<DogWithName>());
+        const auto m = run_ms(mutexProxy, threads);
+        const auto f = run_ms(fcProxy, threads);
+        std::cout << threads << " | " << m << " | " << f << " | " << fcProxy.averageBatch() << std::endl;
+    }
+    return 0;
+}
+
+/*------------- Output (1 core sandbox) -----------------------
+The name: Dog_
+After write: Dog_Harry
+Caught exception: vector::_M_range_check: __n (which is 3) >= this->size() (which is 0)
+Still usable, size 1
+threads | mutex ms | flat combining ms | avg batch
+2 | 10.5069 | 17.9544 | 1.00001
+4 | 10.1058 | 20.9596 | 1.00002
+8 | 10.0467 | 18.2029 | 1.00002
+16 | 10.5915 | 20.2289 | 1.00007
+32 | 13.8253 | 22.7668 | 1.00004
+64 | 11.7847 | 20.8809 | 1.00008
+On a single core threads never overlap, so batches stay at ~1 and only the
+publication overhead shows; the gain needs real parallel callers.
+-------------------------------------------------------------*/
@@ -0,0 +1,319 @@
+/*----------------------------------------------------------------------------------
+Futex-based event and parking primitives (Linux)
+cv.wait in ThreadSynchronization.cpp and the std::promise/std::future handoff in
+std::promise.cpp both wake one waiter through a mutex, a condition variable and,
+for the future, a heap-allocated shared state. A futex lets a thread sleep on any
+32-bit word: the kernel is only entered when somebody really has to sleep or be
+woken, everything else is one atomic instruction.
+    - OneShotEvent   - set() once, any number of wait()ers are released for good
+    - AutoResetEvent - every set() releases exactly one wait()er (or lets the next
+                       one through); repeated set() without waiters does not stack
+    - ParkingLot     - address-based waits, like WebKit's ParkingLot: any object can
+                       park threads on its own address without storing a futex word.
+                       Waiters live in a hashed bucket table, woken with unpark_one()
+                       or unpark_all()
+All waits spin for a short while before calling futex(FUTEX_WAIT), because the
+handoff is often over before a syscall would even return.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace futex {
+    // std::atomic<std::uint32_t> is layout compatible with uint32_t on Linux targets
+    inline void wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+    inline void wake(std::atomic<std::uint32_t>& word, int count) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+    // Spins until ready() or the budget runs out; returns ready()
+    template<typename Ready>
+    bool spin(Ready ready, int iterations = 128) {
+        for (int i = 0; i < iterations; ++i) {
+            if (ready()) return true;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        return ready();
+    }
+}
+
+class OneShotEvent {
+    public:
+        void set() {
+            if (m_state.exchange(Set, std::memory_order_release) == Waiting) {
+                futex::wake(m_state, INT_MAX);
+            }
+        }
+        bool is_set() const { return m_state.load(std::memory_order_acquire) == Set; }
+        void wait() {
+            if (futex::spin([this] { return is_set(); })) return;
+            std::uint32_t state = Unset;
+            // Unset -> Waiting tells set() that it has to issue the wake syscall
+            if (!m_state.compare_exchange_strong(state, Waiting, std::memory_order_acquire) && state == Set) {
+                return;
+            }
+            while (m_state.load(std::memory_order_acquire) != Set) {
+                futex::wait(m_state, Waiting);
+            }
+        }
+    private:
+        static constexpr std::uint32_t Unset = 0, Set = 1, Waiting = 2;
+        std::atomic<std::uint32_t> m_state{Unset};
+};
+
+class AutoResetEvent {
+    public:
+        // m_status: 1 = signaled, 0 = idle, -n = n threads waiting
+        void set() {
+            int old = m_status.load(std::memory_order_relaxed);
+            while (!m_status.compare_exchange_weak(old, old < 1 ? old + 1 : 1, std::memory_order_release)) {}
+            if (old < 0) {
+                m_permits.fetch_add(1, std::memory_order_release);
+                futex::wake(m_permits, 1);
+            }
+        }
+        void wait() {
+            // Fast path: consume a pending signal, possibly after spinning for it
+            if (futex::spin([this] {
+                    int s = m_status.load(std::memory_order_relaxed);
+                    return s > 0 && m_status.compare_exchange_strong(s, 0, std::memory_order_acquire);
+                })) {
+                return;
+            }
+            if (m_status.fetch_sub(1, std::memory_order_acquire) > 0) {
+                return;
+            }
+            for (;;) {
+                auto permits = m_permits.load(std::memory_order_relaxed);
+                if (permits > 0 && m_permits.compare_exchange_weak(permits, permits - 1, std::memory_order_acquire)) {
+                    return;
+                }
+                if (permits == 0) futex::wait(m_permits, 0);
+            }
+        }
+    private:
+        std::atomic<int> m_status{0};
+        std::atomic<std::uint32_t> m_permits{0};
+};
+
+class ParkingLot {
+    public:
+        // Parks the calling thread on `address` if validate() still holds while the
+        // bucket is locked. Returns false without sleeping otherwise
+        template<typename Validate>
+        bool park(const void* address, Validate validate) {
+            Waiter self{address};
+            auto& bucket = bucketFor(address);
+            {
+                std::lock_guard lock(bucket.mutex);
+                if (!validate()) return false;
+                bucket.waiters.push_back(&self);
+            }
+            if (!futex::spin([&self] { return self.woken.load(std::memory_order_acquire) != 0; })) {
+                while (self.woken.load(std::memory_order_acquire) == 0) {
+                    futex::wait(self.woken, 0);
+                }
+            }
+            return true;
+        }
+        // Returns the number of threads woken
+        std::size_t unpark_one(const void* address) { return unpark(address, 1); }
+        std::size_t unpark_all(const void* address) { return unpark(address, SIZE_MAX); }
+
+        static ParkingLot& global() {
+            static ParkingLot lot;
+            return lot;
+        }
+    private:
+        struct Waiter {
+            const void* address;
+            std::atomic<std::uint32_t> woken{0};
+        };
+        struct alignas(64) Bucket {
+            std::mutex mutex;
+            std::vector<Waiter*> waiters;
+        };
+        std::size_t unpark(const void* address, std::size_t limit) {
+            std::vector<Waiter*> toWake;
+            auto& bucket = bucketFor(address);
+            {
+                std::lock_guard lock(bucket.mutex);
+                auto& w = bucket.waiters;
+                for (auto it = w.begin(); it != w.end() && toWake.size() < limit;) {
+                    if ((*it)->address == address) {
+                        toWake.push_back(*it);
+                        it = w.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+            // The Waiter lives on the parked thread's stack: touch it for the last
+            // time with the store, the wake only uses the address
+            for (auto* waiter : toWake) {
+                waiter->woken.store(1, std::memory_order_release);
+                futex::wake(waiter->woken, 1);
+            }
+            return toWake.size();
+        }
+        Bucket& bucketFor(const void* address) {
+            return m_buckets[(reinterpret_cast<std::uintptr_t>(address) >> 4) % m_buckets.size()];
+        }
+        std::array<Bucket, 256> m_buckets;
+};
+
+// Wake latency: the setter records a timestamp right before waking a waiter that is
+// already asleep; the waiter measures when it runs again
+template<typename MakeSlot, typename Wait, typename Wake>
+double wake_latency_us(int rounds, MakeSlot makeSlot, Wait waitOn, Wake wake) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<decltype(makeSlot())> slots;
+    for (int i = 0; i < rounds; ++i) slots.push_back(makeSlot());
+    std::vector<Clock::time_point> stamps(rounds);
+    double total = 0;
+    std::jthread waiter([&] {
+        for (int i = 0; i < rounds; ++i) {
+            waitOn(*slots[i]);
+            total += std::chrono::duration<double, std::micro>(Clock::now() - stamps[i]).count();
+        }
+    });
+    for (int i = 0; i < rounds; ++i) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        stamps[i] = Clock::now();
+        wake(*slots[i]);
+    }
+    waiter.join();
+    return total / rounds;
+}
+
+// Ping-pong between two threads, returns mean one-way handoff time
+template<typename Signal>
+double pingpong_ns(int rounds, Signal& a, Signal& b) {
+    const auto start = std::chrono::steady_clock::now();
+    std::jthread echo([&] {
+        for (int i = 0; i < rounds; ++i) { a.wait(); b.set(); }
+    });
+    for (int i = 0; i < rounds; ++i) { a.set(); b.wait(); }
+    echo.join();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (2.0 * rounds);
+}
+
+// Auto-reset signals built on the standard primitives, for comparison
+class CvSignal {
+    public:
+        void set() {
+            { std::lock_guard lock(m_mutex); m_flag = true; }
+            m_cv.notify_one();
+        }
+        void wait() {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_flag; });
+            m_flag = false;
+        }
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_flag = false;
+};
+class AtomicWaitSignal {
+    public:
+        void set() { m_flag.store(true, std::memory_order_release); m_flag.notify_one(); }
+        void wait() {
+            m_flag.wait(false, std::memory_order_acquire);
+            m_flag.store(false, std::memory_order_relaxed);
+        }
+    private:
+        std::atomic<bool> m_flag{false};
+};
+
+struct PromiseSlot {
+    std::promise<void> promise;
+    std::future<void> future = promise.get_future();
+};
+
+int main() {
+    // The promise/future example from std::promise.cpp with a OneShotEvent
+    {
+        std::string value;
+        OneShotEvent ready;
+        std::thread th([&] {
+            value = "from thread";
+            ready.set();
+        });
+        ready.wait();
+        th.join();
+        std::cout << value << std::endl;
+    }
+    // The producer/consumer example from ThreadSynchronization.cpp on the ParkingLot
+    {
+        std::atomic<int> data{0};
+        std::jthread consumer([&data] {
+            while (data.load() == 0) {
+                ParkingLot::global().park(&data, [&data] { return data.load() == 0; });
+            }
+            std::cout << "Consumed data: " << data.load() << std::endl;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        data = 42;
+        ParkingLot::global().unpark_all(&data);
+    }
+
+    constexpr int rounds = 2000;
+    std::cout << "Wake latency of a sleeping waiter (mean):" << std::endl;
+    std::cout << "  OneShotEvent        : " << wake_latency_us(rounds,
+        [] { return std::make_unique<OneShotEvent>(); },
+        [](OneShotEvent& e) { e.wait(); }, [](OneShotEvent& e) { e.set(); }) << " us" << std::endl;
+    std::cout << "  std::promise/future : " << wake_latency_us(rounds,
+        [] { return std::make_unique<PromiseSlot>(); },
+        [](PromiseSlot& s) { s.future.wait(); }, [](PromiseSlot& s) { s.promise.set_value(); }) << " us" << std::endl;
+    std::cout << "  condition_variable  : " << wake_latency_us(rounds,
+        [] { return std::make_unique<CvSignal>(); },
+        [](CvSignal& s) { s.wait(); }, [](CvSignal& s) { s.set(); }) << " us" << std::endl;
+    std::cout << "  std::atomic::wait   : " << wake_latency_us(rounds,
+        [] { return std::make_unique<AtomicWaitSignal>(); },
+        [](AtomicWaitSignal& s) { s.wait(); }, [](AtomicWaitSignal& s) { s.set(); }) << " us" << std::endl;
+
+    constexpr int pings = 50'000;
+    AutoResetEvent e1, e2;
+    CvSignal c1, c2;
+    AtomicWaitSignal a1, a2;
+    std::cout << "Ping-pong handoff:" << std::endl;
+    std::cout << "  AutoResetEvent      : " << pingpong_ns(pings, e1, e2) << " ns" << std::endl;
+    std::cout << "  condition_variable  : " << pingpong_ns(pings, c1, c2) << " ns" << std::endl;
+    std::cout << "  std::atomic::wait   : " << pingpong_ns(pings, a1, a2) << " ns" << std::endl;
+    return 0;
+}
+
+/*------------- Output (1 core sandbox) -----------------------
+from thread
+Consumed data: 42
+Wake latency of a sleeping waiter (mean):
+  OneShotEvent        : 3.65608 us
+  std::promise/future : 3.12526 us
+  condition_variable  : 3.11916 us
+  std::atomic::wait   : 5.00537 us
+Ping-pong handoff:
+  AutoResetEvent      : 3251.79 ns
+  condition_variable  : 1296.39 ns
+  std::atomic::wait   : 1236.81 ns
+On one core every wake is a context switch, which dominates all four; the
+spin phase of AutoResetEvent only pays off when the threads run on separate cores.
+-------------------------------------------------------------*/
@@ -0,0 +1,306 @@
+/*---------------------------------------------------------------------------------
+Integer priority queues: radix heap and bucket queue
+Task::priority in std::priority_queue.cpp is a small int, yet std::priority_queue
+compares and swaps O(log n) elements on every push and pop. When the key is an
+integer there are cheaper structures, both with the push/emplace/top/pop/empty/size
+interface of std::priority_queue<Task>:
+    - RadixHeap   - monotone: while it is not empty, a pushed task must not have a
+                    higher priority than the current top (event simulation,
+                    Dijkstra, tasks that only ever get re-queued lower). Items sit in
+                    33 buckets keyed by the highest bit where their key differs from
+                    the key of the current top; every item moves down at most 32 times over
+                    its lifetime, so push is O(1) and pop is amortized O(32)
+    - BucketQueue - any order of pushes, but priorities within a bounded range set
+                    at construction. One vector per priority level plus a bitmap of
+                    non-empty levels, so push is O(1) and pop scans 64 levels per word
+Equal priorities come out in no particular order, as with std::priority_queue.
+DaryHeap<T, 4> is the 4-ary heap used as a second baseline: shallower than the
+binary heap and its four children share a cache line.
+----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+// Task structure
+struct Task {
+    int priority;                   // Higher value = Higher priority
+    std::function<void()> action;   // The function to execute
+};
+
+// Needed for proper sorting
+bool operator<(const Task& t1, const Task& t2) {
+    return t1.priority < t2.priority;  // Higher priority comes first;
+}
+
+// Unsigned key that is smallest for the highest priority
+struct HighestPriorityFirst {
+    template<typename T>
+    std::uint32_t operator()(const T& item) const {
+        return ~(static_cast<std::uint32_t>(item.priority) ^ 0x8000'0000u);
+    }
+};
+struct ByPriority {
+    template<typename T>
+    int operator()(const T& item) const { return item.priority; }
+};
+
+template<typename T, typename KeyOf = HighestPriorityFirst>
+class RadixHeap {
+    public:
+        bool empty() const { return m_size == 0; }
+        std::size_t size() const { return m_size; }
+        const T& top() const {
+            if (m_buckets[0].empty()) refill();
+            return m_buckets[0].back();
+        }
+        void push(T value) {
+            const auto key = m_keyOf(value);
+            if (key < m_last) {
+                throw std::out_of_range("RadixHeap: pushed a higher priority than the current top");
+            }
+            m_buckets[bucketOf(key)].push_back(std::move(value));
+            ++m_size;
+        }
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            push(T{std::forward<Args>(args)...});
+        }
+        void pop() {
+            if (m_buckets[0].empty()) refill();
+            m_buckets[0].pop_back();
+            if (--m_size == 0) m_last = 0;   // an empty heap accepts any priority
+        }
+    private:
+        std::size_t bucketOf(std::uint32_t key) const {
+            return std::bit_width(key ^ m_last);
+        }
+        // Makes bucket 0 hold the top: the lowest non-empty bucket is redistributed
+        // around its minimum key, and because its items only differ from that
+        // minimum below bit i they all land in lower buckets
+        void refill() const {
+            auto i = std::size_t{1};
+            while (m_buckets[i].empty()) ++i;
+            auto& source = m_buckets[i];
+            m_last = m_keyOf(*std::min_element(source.begin(), source.end(),
+                [this](const T& a, const T& b) { return m_keyOf(a) < m_keyOf(b); }));
+            for (auto& item : source) {
+                m_buckets[bucketOf(m_keyOf(item))].push_back(std::move(item));
+            }
+            source.clear();   // keeps the capacity for the next round
+        }
+        // top() refills lazily, so the buckets change under a const call
+        mutable std::vector<T> m_buckets[33];
+        mutable std::uint32_t m_last = 0;
+        std::size_t m_size = 0;
+        [[no_unique_address]] KeyOf m_keyOf;
+};
+
+template<typename T, typename PriorityOf = ByPriority>
+class BucketQueue {
+    public:
+        BucketQueue(int minPriority, int maxPriority)
+            : m_min(minPriority), m_levels(static_cast<std::size_t>(maxPriority - minPriority) + 1),
+              m_nonEmpty((m_levels.size() + 63) / 64, 0)
+        {}
+        bool empty() const { return m_size == 0; }
+        std::size_t size() const { return m_size; }
+        const T& top() const { return m_levels[m_top].back(); }
+        void push(T value) {
+            const auto priority = m_priorityOf(value);
+            if (priority < m_min || priority - m_min >= static_cast<long long>(m_levels.size())) {
+                throw std::out_of_range("BucketQueue: priority outside the configured range");
+            }
+            const auto level = static_cast<std::size_t>(priority - m_min);
+            m_levels[level].push_back(std::move(value));
+            m_nonEmpty[level / 64] |= std::uint64_t{1} << (level % 64);
+            if (m_size++ == 0 || level > m_top) m_top = level;
+        }
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            push(T{std::forward<Args>(args)...});
+        }
+        void pop() {
+            auto& level = m_levels[m_top];
+            level.pop_back();
+            --m_size;
+            if (!level.empty()) return;
+            m_nonEmpty[m_top / 64] &= ~(std::uint64_t{1} << (m_top % 64));
+            if (m_size == 0) return;
+            // Highest set bit at or below m_top
+            for (auto word = m_top / 64;; --word) {
+                if (m_nonEmpty[word] != 0) {
+                    m_top = word * 64 + 63 - std::countl_zero(m_nonEmpty[word]);
+                    return;
+                }
+            }
+        }
+    private:
+        const int m_min;
+        std::vector<std::vector<T>> m_levels;
+        std::vector<std::uint64_t> m_nonEmpty;
+        std::size_t m_top = 0;
+        std::size_t m_size = 0;
+        [[no_unique_address]] PriorityOf m_priorityOf;
+};
+
+template<typename T, std::size_t D = 4, typename Compare = std::less<T>>
+class DaryHeap {
+    public:
+        bool empty() const { return m_items.empty(); }
+        std::size_t size() const { return m_items.size(); }
+        const T& top() const { return m_items.front(); }
+        void push(T value) {
+            auto hole = m_items.size();
+            m_items.emplace_back();
+            while (hole > 0) {
+                const auto parent = (hole - 1) / D;
+                if (!m_compare(m_items[parent], value)) break;
+                m_items[hole] = std::move(m_items[parent]);
+                hole = parent;
+            }
+            m_items[hole] = std::move(value);
+        }
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            push(T{std::forward<Args>(args)...});
+        }
+        void pop() {
+            T value = std::move(m_items.back());
+            m_items.pop_back();
+            const auto n = m_items.size();
+            if (n == 0) return;
+            std::size_t hole = 0;
+            for (;;) {
+                const auto first = hole * D + 1;
+                if (first >= n) break;
+                auto best = first;
+                for (auto c = first + 1; c < std::min(first + D, n); ++c) {
+                    if (m_compare(m_items[best], m_items[c])) best = c;
+                }
+                if (!m_compare(value, m_items[best])) break;
+                m_items[hole] = std::move(m_items[best]);
+                hole = best;
+            }
+            m_items[hole] = std::move(value);
+        }
+    private:
+        std::vector<T> m_items;
+        Compare m_compare;
+};
+
+// Small trivially copyable item for the benchmark; a Task with its std::function
+// would mostly measure copying the callable
+struct Job {
+    int priority;
+    std::uint32_t id;
+};
+bool operator<(const Job& j1, const Job& j2) {
+    return j1.priority < j2.priority;
+}
+
+// Pushes n jobs with priorities in [0, levels), then pops them all
+template<typename Queue>
+double fill_drain_ns(Queue queue, std::size_t n, int levels) {
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> prio{0, levels - 1};
+    std::vector<Job> jobs(n);
+    for (std::size_t i = 0; i < n; ++i) jobs[i] = {prio(rng), static_cast<std::uint32_t>(i)};
+    long long checksum = 0;
+    int previous = levels;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& job : jobs) queue.push(job);
+    while (!queue.empty()) {
+        const int p = queue.top().priority;
+        if (p > previous) throw std::logic_error("wrong order");
+        previous = p;
+        checksum += p;
+        queue.pop();
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (checksum < 0) std::cout << checksum;
+    return ns / n;
+}
+
+// Hold model: keep n jobs queued, repeatedly pop the top and re-queue it a few
+// levels lower (monotone, so the radix heap can take part)
+template<typename Queue>
+double hold_ns(Queue queue, std::size_t n, int levels, int holds) {
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> prio{0, levels - 1};
+    std::uniform_int_distribution<int> drop{0, 63};
+    for (std::size_t i = 0; i < n; ++i) queue.push(Job{prio(rng), static_cast<std::uint32_t>(i)});
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < holds; ++i) {
+        Job job = queue.top();
+        queue.pop();
+        job.priority = std::max(0, job.priority - drop(rng));
+        queue.push(job);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / holds;
+}
+
+int main() {
+    RadixHeap<Task> taskQueue;
+
+    //Adding tasks
+    taskQueue.emplace(1, [] { std::cout << "Low priority task\n"; });
+    taskQueue.emplace(3, [] { std::cout << "High priority task\n"; });
+    taskQueue.emplace(2, [] { std::cout << "Medium priority task\n"; });
+
+    while (!taskQueue.empty()) {
+        Task currentTask = taskQueue.top();
+        taskQueue.pop();
+        currentTask.action();   // Execute the task
+    }
+
+    constexpr int smallRange = 256;
+    std::cout << "fill + drain, priorities 0.." << smallRange - 1 << ", ns per push+pop" << std::endl;
+    std::cout << "depth | binary heap | 4-ary heap | radix heap | bucket queue" << std::endl;
+    for (std::size_t depth : {1'000u, 100'000u, 10'000'000u}) {
+        std::cout << depth
+                  << " | " << fill_drain_ns(std::priority_queue<Job>{}, depth, smallRange)
+                  << " | " << fill_drain_ns(DaryHeap<Job, 4>{}, depth, smallRange)
+                  << " | " << fill_drain_ns(RadixHeap<Job>{}, depth, smallRange)
+                  << " | " << fill_drain_ns(BucketQueue<Job>{0, smallRange - 1}, depth, smallRange) << std::endl;
+    }
+
+    constexpr int wideRange = 65536;
+    constexpr int holds = 1'000'000;
+    std::cout << "hold (pop + re-queue lower), priorities 0.." << wideRange - 1 << ", ns per hold" << std::endl;
+    std::cout << "depth | binary heap | 4-ary heap | radix heap | bucket queue" << std::endl;
+    for (std::size_t depth : {1'000u, 100'000u, 10'000'000u}) {
+        std::cout << depth
+                  << " | " << hold_ns(std::priority_queue<Job>{}, depth, wideRange, holds)
+                  << " | " << hold_ns(DaryHeap<Job, 4>{}, depth, wideRange, holds)
+                  << " | " << hold_ns(RadixHeap<Job>{}, depth, wideRange, holds)
+                  << " | " << hold_ns(BucketQueue<Job>{0, wideRange - 1}, depth, wideRange, holds) << std::endl;
+    }
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+High priority task
+Medium priority task
+Low priority task
+fill + drain, priorities 0..255, ns per push+pop
+depth | binary heap | 4-ary heap | radix heap | bucket queue
+1000 | 51.487 | 73.324 | 37.122 | 43.797
+100000 | 67.4241 | 110.766 | 27.9764 | 7.60177
+10000000 | 203.433 | 165.433 | 42.3576 | 16.8895
+hold (pop + re-queue lower), priorities 0..65535, ns per hold
+depth | binary heap | 4-ary heap | radix heap | bucket queue
+1000 | 50.1488 | 77.7374 | 25.0549 | 31.7193
+100000 | 110.726 | 112.419 | 22.0973 | 20.2033
+10000000 | 574.405 | 131.14 | 141.062 | 22.5632
+The heaps pay for cache misses along a log(n) path once the queue outgrows the
+cache; the 4-ary heap halves that path. The bucket queue stays flat at every
+depth. The radix heap slows down at 10^7 in the hold test because every refill
+of a big bucket touches memory that has long left the cache.
+-------------------------------------------------------------*/
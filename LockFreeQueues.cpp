@@ -0,0 +1,360 @@
+/*----------------------------------------------------------------------------------
+Lock-free SPSC and MPMC queues for producer/consumer handoff
+The producer/consumer pair in ThreadSynchronization.cpp passes one int through a
+mutex and a condition_variable. That is fine for one value, but a pipeline that
+moves millions of items per second spends most of its time in the lock and in
+futex wake-ups. Two bounded queues replace it:
+    - SpscRing<T, N>  - one producer, one consumer. Head and tail live on separate
+                        cache lines and each side caches the other side's index,
+                        so the shared lines are only touched when the cached view
+                        runs out. Batched push/pop move many items per index update
+    - MpmcQueue<T, N> - Dmitry Vyukov's bounded MPMC queue: every cell carries a
+                        sequence number, producers and consumers claim positions
+                        with one CAS and never block each other
+Blocking push()/pop() use HybridWaiter: spin with a CPU pause, then yield, then
+sleep in std::atomic::wait (a futex on Linux). Producers only issue the wake-up
+syscall when somebody is actually asleep.
+Capacities must be powers of two.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <array>
+#include <span>
+#include <chrono>
+#include <optional>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+class HybridWaiter {
+    public:
+        template<typename Ready>
+        void wait(Ready ready) {
+            for (int i = 0; i < SpinIterations; ++i) {
+                if (ready()) return;
+                cpu_relax();
+            }
+            for (int i = 0; i < YieldIterations; ++i) {
+                if (ready()) return;
+                std::this_thread::yield();
+            }
+            // Announce the sleeper before the final check; pairs with the fence in notify()
+            m_sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (;;) {
+                const auto epoch = m_epoch.load(std::memory_order_acquire);
+                if (ready()) break;
+                m_epoch.wait(epoch, std::memory_order_acquire);
+            }
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        // Call after making the condition true. Costs one fence and no shared
+        // write unless somebody sleeps
+        void notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+                m_epoch.fetch_add(1, std::memory_order_release);
+                m_epoch.notify_all();
+            }
+        }
+    private:
+        static constexpr int SpinIterations = 256;
+        static constexpr int YieldIterations = 16;
+        alignas(64) std::atomic<std::uint32_t> m_epoch{0};
+        std::atomic<int> m_sleepers{0};
+};
+
+template<typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_nothrow_move_assignable_v<T> && std::is_default_constructible_v<T>);
+    public:
+        bool try_push(T value) {
+            return try_push_batch(std::span<T>(&value, 1)) == 1;
+        }
+        // Moves as many items as fit; returns how many were taken
+        std::size_t try_push_batch(std::span<T> items) {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            if (Capacity - (tail - m_cachedHead) < items.size()) {
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+            }
+            const auto count = std::min(items.size(), Capacity - (tail - m_cachedHead));
+            for (std::size_t i = 0; i < count; ++i) {
+                m_buffer[(tail + i) & Mask] = std::move(items[i]);
+            }
+            if (count) {
+                m_tail.store(tail + count, std::memory_order_release);
+                m_notEmpty.notify();
+            }
+            return count;
+        }
+        std::optional<T> try_pop() {
+            T value;
+            if (try_pop_batch(std::span<T>(&value, 1)) == 0) return std::nullopt;
+            return value;
+        }
+        std::size_t try_pop_batch(std::span<T> out) {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if (m_cachedTail - head < out.size()) {
+                m_cachedTail = m_tail.load(std::memory_order_acquire);
+            }
+            const auto count = std::min(out.size(), m_cachedTail - head);
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = std::move(m_buffer[(head + i) & Mask]);
+            }
+            if (count) {
+                m_head.store(head + count, std::memory_order_release);
+                m_notFull.notify();
+            }
+            return count;
+        }
+        void push(T value) {
+            while (try_push_batch(std::span<T>(&value, 1)) == 0) {
+                m_notFull.wait([this] { return m_tail.load(std::memory_order_relaxed) -
+                                               m_head.load(std::memory_order_acquire) < Capacity; });
+            }
+        }
+        T pop() {
+            for (;;) {
+                if (auto value = try_pop()) return std::move(*value);
+                m_notEmpty.wait([this] { return m_tail.load(std::memory_order_acquire) !=
+                                                m_head.load(std::memory_order_relaxed); });
+            }
+        }
+    private:
+        static constexpr std::size_t Mask = Capacity - 1;
+        // Consumer side
+        alignas(64) std::atomic<std::size_t> m_head{0};
+        std::size_t m_cachedTail = 0;
+        // Producer side
+        alignas(64) std::atomic<std::size_t> m_tail{0};
+        std::size_t m_cachedHead = 0;
+        alignas(64) std::array<T, Capacity> m_buffer{};
+        HybridWaiter m_notEmpty;
+        HybridWaiter m_notFull;
+};
+
+template<typename T, std::size_t Capacity>
+class MpmcQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    public:
+        MpmcQueue() {
+            for (std::size_t i = 0; i < Capacity; ++i) {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+        bool try_push(T& value) {
+            auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                auto& cell = m_cells[pos & Mask];
+                const auto seq = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if (diff == 0) {
+                    if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        m_notEmpty.notify();
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;   // full
+                } else {
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        std::optional<T> try_pop() {
+            auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                auto& cell = m_cells[pos & Mask];
+                const auto seq = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        T value = std::move(cell.value);
+                        cell.sequence.store(pos + Capacity, std::memory_order_release);
+                        m_notFull.notify();
+                        return value;
+                    }
+                } else if (diff < 0) {
+                    return std::nullopt;   // empty
+                } else {
+                    pos = m_dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        // Cells are claimed one by one: in an MPMC ring a consecutive range is not
+        // guaranteed to be free, but the batch still saves the waiter round trips
+        std::size_t try_push_batch(std::span<T> items) {
+            std::size_t count = 0;
+            while (count < items.size() && try_push(items[count])) ++count;
+            return count;
+        }
+        std::size_t try_pop_batch(std::span<T> out) {
+            std::size_t count = 0;
+            while (count < out.size()) {
+                auto value = try_pop();
+                if (!value) break;
+                out[count++] = std::move(*value);
+            }
+            return count;
+        }
+        void push(T value) {
+            while (!try_push(value)) {
+                m_notFull.wait([this] { return !full(); });
+            }
+        }
+        T pop() {
+            for (;;) {
+                if (auto value = try_pop()) return std::move(*value);
+                m_notEmpty.wait([this] { return !empty(); });
+            }
+        }
+    private:
+        bool empty() const {
+            const auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+            return m_cells[pos & Mask].sequence.load(std::memory_order_acquire) != pos + 1;
+        }
+        bool full() const {
+            const auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+            return m_cells[pos & Mask].sequence.load(std::memory_order_acquire) != pos;
+        }
+        static constexpr std::size_t Mask = Capacity - 1;
+        struct alignas(64) Cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+        alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+        alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
+        std::array<Cell, Capacity> m_cells;
+        HybridWaiter m_notEmpty;
+        HybridWaiter m_notFull;
+};
+
+// Baseline: the mutex + condition_variable handoff from ThreadSynchronization.cpp
+template<typename T>
+class LockedQueue {
+    public:
+        void push(T value) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_items.push(std::move(value));
+            }
+            m_cv.notify_one();
+        }
+        T pop() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return !m_items.empty(); });
+            T value = std::move(m_items.front());
+            m_items.pop();
+            return value;
+        }
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::queue<T> m_items;
+};
+
+template<typename Queue>
+double items_per_second(Queue& queue, int producers, int consumers, std::int64_t items) {
+    const auto perProducer = items / producers;
+    const auto perConsumer = items / consumers;
+    std::atomic<std::int64_t> checksum{0};
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&] {
+                std::int64_t sum = 0;
+                for (std::int64_t i = 0; i < perConsumer; ++i) sum += queue.pop();
+                checksum += sum;
+            });
+        }
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                for (std::int64_t i = 1; i <= perProducer; ++i) queue.push(i);
+            });
+        }
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (checksum != producers * (perProducer * (perProducer + 1) / 2)) std::cout << "checksum mismatch!\n";
+    return static_cast<double>(items) / seconds;
+}
+
+// Ping-pong through two queues; returns the mean one-way handoff latency
+template<typename Queue>
+double handoff_ns(int rounds) {
+    auto ping = std::make_unique<Queue>();
+    auto pong = std::make_unique<Queue>();
+    const auto start = std::chrono::steady_clock::now();
+    std::jthread echo([&] {
+        for (int i = 0; i < rounds; ++i) pong->push(ping->pop());
+    });
+    for (int i = 0; i < rounds; ++i) {
+        ping->push(i);
+        pong->pop();
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / (2.0 * rounds);
+}
+
+int main() {
+    SpscRing<int, 8> ring;
+    std::jthread consumer([&ring] {
+        std::cout << "Consumed data: " << ring.pop() << std::endl;
+    });
+    ring.push(42);
+    consumer.join();
+
+    std::array<int, 4> batch{1, 2, 3, 4}, out{};
+    ring.try_push_batch(batch);
+    std::cout << "Popped " << ring.try_pop_batch(out) << " items in one batch" << std::endl;
+
+    constexpr std::int64_t items = 2'000'000;
+    auto locked = std::make_unique<LockedQueue<std::int64_t>>();
+    auto spsc = std::make_unique<SpscRing<std::int64_t, 4096>>();
+    auto mpmc = std::make_unique<MpmcQueue<std::int64_t, 4096>>();
+    auto lockedMulti = std::make_unique<LockedQueue<std::int64_t>>();
+    auto mpmcMulti = std::make_unique<MpmcQueue<std::int64_t, 4096>>();
+    std::cout << "1P1C mutex/cv : " << items_per_second(*locked, 1, 1, items) << " items/s\n";
+    std::cout << "1P1C SPSC     : " << items_per_second(*spsc, 1, 1, items) << " items/s\n";
+    std::cout << "1P1C MPMC     : " << items_per_second(*mpmc, 1, 1, items) << " items/s\n";
+    std::cout << "4P4C mutex/cv : " << items_per_second(*lockedMulti, 4, 4, items) << " items/s\n";
+    std::cout << "4P4C MPMC     : " << items_per_second(*mpmcMulti, 4, 4, items) << " items/s\n";
+
+    constexpr int rounds = 20'000;
+    std::cout << "handoff mutex/cv : " << handoff_ns<LockedQueue<std::int64_t>>(rounds) << " ns\n";
+    std::cout << "handoff SPSC     : " << handoff_ns<SpscRing<std::int64_t, 64>>(rounds) << " ns\n";
+    std::cout << "handoff MPMC     : " << handoff_ns<MpmcQueue<std::int64_t, 64>>(rounds) << " ns\n";
+    return 0;
+}
+
+/*------------- Output (1 core sandbox) -----------------------
+Consumed data: 42
+Popped 4 items in one batch
+1P1C mutex/cv : 7.92264e+06 items/s
+1P1C SPSC     : 4.244e+07 items/s
+1P1C MPMC     : 2.38786e+07 items/s
+4P4C mutex/cv : 7.75469e+06 items/s
+4P4C MPMC     : 4.22437e+06 items/s
+handoff mutex/cv : 1366.66 ns
+handoff SPSC     : 5120.11 ns
+handoff MPMC     : 5942.98 ns
+With a single core the spinning phase only burns the timeslice of the thread
+that should run next, so the ping-pong latency favours the cv; with the two
+threads on separate cores the spin phase catches the handoff without a syscall.
+-------------------------------------------------------------*/
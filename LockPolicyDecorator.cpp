@@ -0,0 +1,383 @@
+/*----------------------------------------------------------------------------------
+Policy-based concurrency decorator with contention telemetry
+The decorator in DecoratorWrapper.cpp hard-codes a std::mutex. Here the locking
+strategy is a template parameter, chosen at compile time:
+    - MutexLock        - std::mutex
+    - AdaptiveSpinLock - spins with a CPU pause, adapts the spin budget to how long
+                         the lock was recently held, then falls back to yield()
+    - SharedLock       - std::shared_mutex, const calls take the shared side
+    - NoLock           - for objects that are known to be thread confined
+Synchronized<T, Lock, Stats> owns any object and only hands it out inside write()
+or read() callbacks, so every interface can be wrapped without writing one
+forwarding function per method. Every acquisition can be recorded by LockStats:
+acquisition and contention counts, total wait time and log2 histograms of wait and
+hold times. exportText() prints them in the Prometheus text format (counters, and
+histograms with cumulative le buckets, +Inf, _sum and _count) so contended
+decorators can be found in production without an external profiler. Passing
+NoStats removes the clock reads entirely.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+
+// Lock policies. All of them provide lock/unlock and lock_shared/unlock_shared so
+// Synchronized can use them interchangeably
+class MutexLock {
+    public:
+        void lock() { m_mutex.lock(); }
+        bool try_lock() { return m_mutex.try_lock(); }
+        void unlock() { m_mutex.unlock(); }
+        void lock_shared() { lock(); }
+        bool try_lock_shared() { return try_lock(); }
+        void unlock_shared() { unlock(); }
+    private:
+        std::mutex m_mutex;
+};
+
+class AdaptiveSpinLock {
+    public:
+        void lock() {
+            const int budget = m_spinBudget.load(std::memory_order_relaxed);
+            int spins = 0;
+            while (!try_lock()) {
+                if (spins < budget) {
+                    cpu_relax();
+                    ++spins;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            // Moving average: move the budget towards twice the spins that paid
+            // off, halve it when the owner kept the lock for longer than that
+            const int next = spins < budget ? std::clamp(budget + (2 * spins - budget) / 8, MinSpins, MaxSpins)
+                                            : std::max(MinSpins, budget / 2);
+            m_spinBudget.store(next, std::memory_order_relaxed);
+        }
+        bool try_lock() {
+            return !m_locked.load(std::memory_order_relaxed) &&
+                   !m_locked.exchange(true, std::memory_order_acquire);
+        }
+        void unlock() { m_locked.store(false, std::memory_order_release); }
+        void lock_shared() { lock(); }
+        bool try_lock_shared() { return try_lock(); }
+        void unlock_shared() { unlock(); }
+    private:
+        static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+        static constexpr int MinSpins = 16;
+        static constexpr int MaxSpins = 4096;
+        std::atomic<bool> m_locked{false};
+        std::atomic<int> m_spinBudget{256};
+};
+
+class SharedLock {
+    public:
+        void lock() { m_mutex.lock(); }
+        bool try_lock() { return m_mutex.try_lock(); }
+        void unlock() { m_mutex.unlock(); }
+        void lock_shared() { m_mutex.lock_shared(); }
+        bool try_lock_shared() { return m_mutex.try_lock_shared(); }
+        void unlock_shared() { m_mutex.unlock_shared(); }
+    private:
+        std::shared_mutex m_mutex;
+};
+
+class NoLock {
+    public:
+        void lock() {}
+        bool try_lock() { return true; }
+        void unlock() {}
+        void lock_shared() {}
+        bool try_lock_shared() { return true; }
+        void unlock_shared() {}
+};
+
+// Lock-free counters and histograms, striped over Shards cache-line aligned shards.
+// Threads are dealt shards round robin, so up to Shards threads never write the same
+// line and readers of a SharedLock do not serialize on the stats. The accessors and
+// exportText() add the shards up, so they are meant for reporting, not hot paths
+class LockStats {
+    public:
+        static constexpr bool enabled = true;
+        // Bucket i < Buckets - 1 holds (2^(i-1), 2^i] ns (bucket 0 holds 0 and 1 ns);
+        // the last one holds everything larger and is exported as le="+Inf"
+        static constexpr std::size_t Buckets = 40;
+        static constexpr std::size_t Shards = 16;
+
+        // One critical section: called after the lock has been released
+        void record(std::uint64_t waitNs, bool contended, std::uint64_t holdNs) {
+            auto& shard = m_shards[shard_index()];
+            shard.acquisitions.fetch_add(1, std::memory_order_relaxed);
+            if (contended) {
+                shard.contended.fetch_add(1, std::memory_order_relaxed);
+                shard.waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+            }
+            shard.waitHistogram[bucket(waitNs)].fetch_add(1, std::memory_order_relaxed);
+            shard.holdNs.fetch_add(holdNs, std::memory_order_relaxed);
+            shard.holdHistogram[bucket(holdNs)].fetch_add(1, std::memory_order_relaxed);
+        }
+        std::uint64_t acquisitions() const { return sum(&Shard::acquisitions); }
+        std::uint64_t contended() const { return sum(&Shard::contended); }
+        std::uint64_t waitNs() const { return sum(&Shard::waitNs); }
+
+        void exportText(std::ostream& out, std::string_view name) const {
+            out << "# TYPE " << name << "_acquisitions_total counter\n";
+            out << name << "_acquisitions_total " << acquisitions() << '\n';
+            out << "# TYPE " << name << "_contended_total counter\n";
+            out << name << "_contended_total " << contended() << '\n';
+            exportHistogram(out, name, "_wait_ns", merged(&Shard::waitHistogram), waitNs());
+            exportHistogram(out, name, "_hold_ns", merged(&Shard::holdHistogram), sum(&Shard::holdNs));
+        }
+    private:
+        using Counter = std::atomic<std::uint64_t>;
+        using Histogram = std::array<Counter, Buckets>;
+        using Totals = std::array<std::uint64_t, Buckets>;
+        struct alignas(64) Shard {
+            Counter acquisitions{0};
+            Counter contended{0};
+            Counter waitNs{0};
+            Counter holdNs{0};
+            Histogram waitHistogram{};
+            Histogram holdHistogram{};
+        };
+        static std::size_t shard_index() {
+            static std::atomic<std::size_t> next{0};
+            thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+            return index;
+        }
+        std::uint64_t sum(Counter Shard::* counter) const {
+            std::uint64_t total = 0;
+            for (const auto& shard : m_shards) total += (shard.*counter).load(std::memory_order_relaxed);
+            return total;
+        }
+        Totals merged(Histogram Shard::* histogram) const {
+            Totals totals{};
+            for (const auto& shard : m_shards) {
+                for (std::size_t i = 0; i < Buckets; ++i) totals[i] += (shard.*histogram)[i].load(std::memory_order_relaxed);
+            }
+            return totals;
+        }
+        static std::size_t bucket(std::uint64_t ns) {
+            // bit_width(ns - 1) is the smallest i with ns <= 2^i, so le is inclusive
+            return ns <= 1 ? 0 : std::min<std::size_t>(std::bit_width(ns - 1), Buckets - 1);
+        }
+        static void exportHistogram(std::ostream& out, std::string_view name, std::string_view metric,
+                                    const Totals& histogram, std::uint64_t sum) {
+            out << "# TYPE " << name << metric << " histogram\n";
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i + 1 < Buckets; ++i) {
+                cumulative += histogram[i];
+                out << name << metric << "_bucket{le=\"" << (std::uint64_t{1} << i) << "\"} " << cumulative << '\n';
+            }
+            cumulative += histogram[Buckets - 1];
+            out << name << metric << "_bucket{le=\"+Inf\"} " << cumulative << '\n';
+            out << name << metric << "_sum " << sum << '\n';
+            out << name << metric << "_count " << cumulative << '\n';
+        }
+    private:
+        std::array<Shard, Shards> m_shards;
+};
+
+struct NoStats {
+    static constexpr bool enabled = false;
+    void record(std::uint64_t, bool, std::uint64_t) {}
+    void exportText(std::ostream&, std::string_view) const {}
+};
+
+template<typename T, typename Lock = MutexLock, typename Stats = LockStats>
+class Synchronized {
+    public:
+        template<typename... Args>
+        explicit Synchronized(Args&&... args) : m_value(std::forward<Args>(args)...) {}
+    public:
+        // Exclusive access
+        template<typename F>
+        decltype(auto) write(F&& f) {
+            Guard<false> guard{*this};
+            return std::forward<F>(f)(m_value);
+        }
+        // Shared access; exclusive for lock policies without a shared side
+        template<typename F>
+        decltype(auto) read(F&& f) const {
+            Guard<true> guard{*this};
+            return std::forward<F>(f)(static_cast<const T&>(m_value));
+        }
+        const Stats& stats() const { return m_stats; }
+    private:
+        using Clock = std::chrono::steady_clock;
+        static std::uint64_t nanos(Clock::duration d) {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        }
+        template<bool Shared>
+        class Guard {
+            public:
+                // An acquisition that succeeds on the first try records a wait of 0
+                // and costs one clock read; only a contended one times its wait
+                explicit Guard(const Synchronized& owner) : m_owner(owner) {
+                    if constexpr (Stats::enabled) {
+                        m_contended = !(Shared ? m_owner.m_lock.try_lock_shared() : m_owner.m_lock.try_lock());
+                        if (m_contended) {
+                            const auto start = Clock::now();
+                            if constexpr (Shared) m_owner.m_lock.lock_shared(); else m_owner.m_lock.lock();
+                            m_acquired = Clock::now();
+                            m_waitNs = nanos(m_acquired - start);
+                        } else {
+                            m_acquired = Clock::now();
+                        }
+                    } else {
+                        if constexpr (Shared) m_owner.m_lock.lock_shared(); else m_owner.m_lock.lock();
+                    }
+                }
+                // Stats are written after unlocking, so they never extend the hold time
+                ~Guard() {
+                    if constexpr (Stats::enabled) {
+                        const auto released = Clock::now();
+                        if constexpr (Shared) m_owner.m_lock.unlock_shared(); else m_owner.m_lock.unlock();
+                        m_owner.m_stats.record(m_waitNs, m_contended, nanos(released - m_acquired));
+                    } else {
+                        if constexpr (Shared) m_owner.m_lock.unlock_shared(); else m_owner.m_lock.unlock();
+                    }
+                }
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+            private:
+                const Synchronized& m_owner;
+                Clock::time_point m_acquired{};
+                std::uint64_t m_waitNs = 0;
+                bool m_contended = false;
+        };
+    private:
+        T m_value;
+        mutable Lock m_lock;
+        mutable Stats m_stats;
+};
+
+// Abstract Interface to inherit
+class AnimalWithName {
+    public:
+        virtual ~AnimalWithName() = default;
+    public:
+        virtual void setName(const std::string& name) = 0;
+        virtual std::string getName() const = 0;
+};
+// Implementation without protection against concurrency
+class DogWithName : public AnimalWithName {
+    public:
+        void setName(const std::string& name) override {
+            m_name = name;
+        }
+        std::string getName() const override {
+            return "Dog_" + m_name;
+        }
+    private:
+        std::string m_name;
+};
+// MultiThreadedAnimalProxy with the lock strategy as a parameter
+template<typename Lock, typename Stats = LockStats>
+class ConcurrentAnimalProxy : public AnimalWithName {
+    public:
+        ConcurrentAnimalProxy(std::unique_ptr<AnimalWithName> animal) : m_animal(std::move(animal))
+        {}
+    public:
+        void setName(const std::string& name) override {
+            m_animal.write([&](auto& animal) { animal->setName(name); });
+        }
+        std::string getName() const override {
+            return m_animal.read([](const auto& animal) { return animal->getName(); });
+        }
+        const Stats& stats() const { return m_animal.stats(); }
+    private:
+        Synchronized<std::unique_ptr<AnimalWithName>, Lock, Stats> m_animal;
+};
+
+template<typename Proxy>
+void hammer(Proxy& proxy, std::string_view name) {
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&proxy, t] {
+                for (int i = 0; i < 50'000; ++i) {
+                    if (i % 100 == 0) proxy.setName("Rex" + std::to_string(t));
+                    else proxy.getName();
+                }
+            });
+        }
+    }
+    const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "# " << name << ": " << ms << " ms\n";
+    proxy.stats().exportText(std::cout, name);
+}
+
+int main() {
+    ConcurrentAnimalProxy<MutexLock> animal(std::make_unique<DogWithName>());
+    auto th = std::thread([&animal](){
+        auto name = animal.getName();
+        std::cout << "The name: " << name << std::endl;
+    });
+    animal.setName("Harry");
+    th.join();
+
+    ConcurrentAnimalProxy<MutexLock> mutexProxy(std::make_unique<DogWithName>());
+    ConcurrentAnimalProxy<AdaptiveSpinLock> spinProxy(std::make_unique<DogWithName>());
+    ConcurrentAnimalProxy<SharedLock> sharedProxy(std::make_unique<DogWithName>());
+    ConcurrentAnimalProxy<MutexLock, NoStats> plainProxy(std::make_unique<DogWithName>());
+    hammer(mutexProxy, "dog_mutex");
+    hammer(spinProxy, "dog_spin");
+    hammer(sharedProxy, "dog_shared");
+    hammer(plainProxy, "dog_mutex_nostats");
+
+    // Thread-confined object: no lock, still counted
+    Synchronized<std::vector<int>, NoLock> local;
+    local.write([](auto& v) { v.push_back(1); });
+    std::cout << "local size: " << local.read([](const auto& v) { return v.size(); })
+              << ", acquisitions: " << local.stats().acquisitions() << std::endl;
+    return 0;
+}
+
+/*------------- Output (trimmed, 1 core sandbox) --------------
+The name: Dog_
+# dog_mutex: 31.0736 ms
+# TYPE dog_mutex_acquisitions_total counter
+dog_mutex_acquisitions_total 200000
+# TYPE dog_mutex_contended_total counter
+dog_mutex_contended_total 7
+# TYPE dog_mutex_wait_ns histogram
+dog_mutex_wait_ns_bucket{le="1"} 199993
+...
+dog_mutex_wait_ns_bucket{le="+Inf"} 200000
+dog_mutex_wait_ns_sum 22404811
+dog_mutex_wait_ns_count 200000
+# TYPE dog_mutex_hold_ns histogram
+...
+dog_mutex_hold_ns_bucket{le="64"} 198538
+dog_mutex_hold_ns_bucket{le="128"} 199950
+...
+dog_mutex_hold_ns_bucket{le="+Inf"} 200000
+dog_mutex_hold_ns_sum 10525627
+dog_mutex_hold_ns_count 200000
+# dog_spin: 28.5265 ms
+...
+# dog_shared: 31.2795 ms
+...
+# dog_mutex_nostats: 6.40603 ms
+local size: 1, acquisitions: 2
+Most of the remaining overhead is the two steady_clock reads per call, about
+40 ns each in this sandbox.
+-------------------------------------------------------------*/
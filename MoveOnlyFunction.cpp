@@ -0,0 +1,289 @@
+/*---------------------------------------------------------------------------------
+Allocation-free, move-only task callable
+Task in std::priority_queue.cpp stores std::function<void()>. Two things cost
+there on every task:
+    - std::function keeps only about 16 bytes inline (libstdc++), any bigger
+      capture goes to the heap
+    - std::priority_queue::top() is const, so the pop loop copies the whole Task,
+      and with it the std::function (another allocation for big captures)
+InplaceFunction<R(Args...), Capacity> is move-only and stores the callable in an
+inline buffer of Capacity bytes. Callables that do not fit (or cannot be moved
+without throwing) still work but go to the heap, so the common case costs nothing.
+Because it is move-only it also accepts move-only captures such as unique_ptr.
+TaskHeap keeps the tasks in a std::vector with std::push_heap/std::pop_heap and
+hands the top out by move, so no Task is ever copied.
+----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<typename Signature, std::size_t Capacity = 48>
+class InplaceFunction;
+
+template<typename R, typename... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+    public:
+        InplaceFunction() noexcept = default;
+        template<typename F>
+        requires (!std::is_same_v<std::decay_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+        InplaceFunction(F&& f) {
+            using Fn = std::decay_t<F>;
+            if constexpr (fitsInline<Fn>()) {
+                ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(f));
+            } else {
+                ::new (static_cast<void*>(m_storage)) Fn*(new Fn(std::forward<F>(f)));
+            }
+            m_ops = &s_ops<Fn>;
+        }
+        InplaceFunction(InplaceFunction&& other) noexcept {
+            moveFrom(other);
+        }
+        InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+        InplaceFunction(const InplaceFunction&) = delete;
+        InplaceFunction& operator=(const InplaceFunction&) = delete;
+        ~InplaceFunction() { reset(); }
+
+        R operator()(Args... args) {
+            if (!m_ops) throw std::bad_function_call();
+            return m_ops->invoke(m_storage, std::forward<Args>(args)...);
+        }
+        explicit operator bool() const noexcept { return m_ops != nullptr; }
+        void reset() noexcept {
+            if (m_ops) {
+                m_ops->destroy(m_storage);
+                m_ops = nullptr;
+            }
+        }
+        // True if a callable of type F is stored without a heap allocation
+        template<typename F>
+        static constexpr bool fitsInline() {
+            return sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) &&
+                   std::is_nothrow_move_constructible_v<F>;
+        }
+    private:
+        // One static table per stored type instead of a virtual base class.
+        // move is null when the bytes can simply be copied (trivially copyable
+        // callables and heap pointers), which keeps heap sifts cheap
+        struct Ops {
+            R (*invoke)(std::byte*, Args&&...);
+            void (*move)(std::byte* from, std::byte* to) noexcept;
+            void (*destroy)(std::byte*) noexcept;
+        };
+        void moveFrom(InplaceFunction& other) noexcept {
+            if (!other.m_ops) return;
+            if (other.m_ops->move) {
+                other.m_ops->move(other.m_storage, m_storage);
+            } else {
+                std::memcpy(m_storage, other.m_storage, Capacity);
+            }
+            m_ops = std::exchange(other.m_ops, nullptr);
+        }
+        template<typename Fn>
+        static constexpr bool bitwiseMovable() {
+            return !fitsInline<Fn>() || (std::is_trivially_copyable_v<Fn> && std::is_trivially_destructible_v<Fn>);
+        }
+        template<typename Fn>
+        static Fn& target(std::byte* storage) {
+            if constexpr (fitsInline<Fn>()) {
+                return *std::launder(reinterpret_cast<Fn*>(storage));
+            } else {
+                return **std::launder(reinterpret_cast<Fn**>(storage));
+            }
+        }
+        template<typename Fn>
+        static constexpr Ops s_ops{
+            [](std::byte* s, Args&&... args) -> R {
+                return std::invoke(target<Fn>(s), std::forward<Args>(args)...);
+            },
+            bitwiseMovable<Fn>() ? nullptr : +[](std::byte* from, std::byte* to) noexcept {
+                Fn& f = target<Fn>(from);
+                ::new (static_cast<void*>(to)) Fn(std::move(f));
+                f.~Fn();
+            },
+            [](std::byte* s) noexcept {
+                if constexpr (fitsInline<Fn>()) {
+                    target<Fn>(s).~Fn();
+                } else {
+                    delete &target<Fn>(s);
+                }
+            }
+        };
+        alignas(std::max_align_t) std::byte m_storage[Capacity];
+        const Ops* m_ops = nullptr;
+};
+
+// Task structure, now move-only
+struct Task {
+    int priority;                                   // Higher value = Higher priority
+    InplaceFunction<void(), 48> action;             // The function to execute
+};
+
+// Needed for proper sorting
+bool operator<(const Task& t1, const Task& t2) {
+    return t1.priority < t2.priority;  // Higher priority comes first;
+}
+
+// Same push/top/pop interface as std::priority_queue, plus pop_top() which moves
+// the greatest element out
+template<typename T, typename Compare = std::less<T>>
+class TaskHeap {
+    public:
+        bool empty() const { return m_items.empty(); }
+        std::size_t size() const { return m_items.size(); }
+        const T& top() const { return m_items.front(); }
+        void reserve(std::size_t n) { m_items.reserve(n); }
+        void push(T value) {
+            m_items.push_back(std::move(value));
+            std::push_heap(m_items.begin(), m_items.end(), m_compare);
+        }
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            m_items.push_back(T{std::forward<Args>(args)...});
+            std::push_heap(m_items.begin(), m_items.end(), m_compare);
+        }
+        void pop() {
+            std::pop_heap(m_items.begin(), m_items.end(), m_compare);
+            m_items.pop_back();
+        }
+        T pop_top() {
+            std::pop_heap(m_items.begin(), m_items.end(), m_compare);
+            T value = std::move(m_items.back());
+            m_items.pop_back();
+            return value;
+        }
+    private:
+        std::vector<T> m_items;
+        Compare m_compare;
+};
+
+// Allocation counter for the benchmark
+static std::atomic<std::size_t> g_allocations{0};
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Baseline Task from std::priority_queue.cpp
+struct StdTask {
+    int priority;
+    std::function<void()> action;
+};
+bool operator<(const StdTask& t1, const StdTask& t2) {
+    return t1.priority < t2.priority;
+}
+
+template<std::size_t CaptureBytes, typename Run>
+void bench(const char* name, Run run) {
+    constexpr int tasks = 200'000;
+    const auto allocationsBefore = g_allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    const long long sum = run(tasks);
+    const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    const auto allocations = g_allocations.load() - allocationsBefore;
+    std::cout << name << " capture " << CaptureBytes << "B: " << ns / tasks << " ns/task, "
+              << static_cast<double>(allocations) / tasks << " allocations/task (sum " << sum << ")\n";
+}
+
+// Sized so that the whole closure, payload plus the &sum reference, is CaptureBytes
+template<std::size_t CaptureBytes>
+struct Payload {
+    long long values[(CaptureBytes - sizeof(long long*)) / sizeof(long long)];
+};
+
+template<std::size_t CaptureBytes>
+void run_benchmarks() {
+    bench<CaptureBytes>("std::priority_queue<StdTask>", [](int tasks) {
+        long long sum = 0;
+        std::priority_queue<StdTask> queue;
+        for (int i = 0; i < tasks; ++i) {
+            Payload<CaptureBytes> payload{};
+            payload.values[0] = i;
+            auto action = [payload, &sum] { sum += payload.values[0]; };
+            static_assert(sizeof(action) == CaptureBytes);
+            queue.push(StdTask{i % 100, std::move(action)});
+        }
+        while (!queue.empty()) {
+            StdTask currentTask = queue.top();   // copy, as in std::priority_queue.cpp
+            queue.pop();
+            currentTask.action();
+        }
+        return sum;
+    });
+    bench<CaptureBytes>("TaskHeap<Task>              ", [](int tasks) {
+        long long sum = 0;
+        TaskHeap<Task> queue;
+        queue.reserve(tasks);
+        for (int i = 0; i < tasks; ++i) {
+            Payload<CaptureBytes> payload{};
+            payload.values[0] = i;
+            auto action = [payload, &sum] { sum += payload.values[0]; };
+            static_assert(sizeof(action) == CaptureBytes);
+            queue.emplace(i % 100, std::move(action));
+        }
+        while (!queue.empty()) {
+            Task currentTask = queue.pop_top();  // moved out, never copied
+            currentTask.action();
+        }
+        return sum;
+    });
+}
+
+int main() {
+    TaskHeap<Task> taskQueue;
+
+    //Adding tasks
+    taskQueue.emplace(1, [] { std::cout << "Low priority task\n"; });
+    taskQueue.emplace(3, [] { std::cout << "High priority task\n"; });
+    taskQueue.emplace(2, [owned = std::make_unique<int>(2)] {
+        std::cout << "Medium priority task, move-only capture " << *owned << "\n";
+    });
+
+    while (!taskQueue.empty()) {
+        Task currentTask = taskQueue.pop_top();
+        currentTask.action();   // Execute the task
+    }
+
+    run_benchmarks<16>();    // fits std::function's small buffer too
+    run_benchmarks<48>();    // exactly Task's inline capacity
+    run_benchmarks<56>();    // one pointer more
+    run_benchmarks<128>();
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+High priority task
+Medium priority task, move-only capture 2
+Low priority task
+std::priority_queue<StdTask> capture 16B: 274.223 ns/task, 9.5e-05 allocations/task (sum 19999900000)
+TaskHeap<Task>               capture 16B: 275.115 ns/task, 5e-06 allocations/task (sum 19999900000)
+std::priority_queue<StdTask> capture 48B: 407.983 ns/task, 2.00009 allocations/task (sum 19999900000)
+TaskHeap<Task>               capture 48B: 296.012 ns/task, 5e-06 allocations/task (sum 19999900000)
+std::priority_queue<StdTask> capture 56B: 560.592 ns/task, 2.00009 allocations/task (sum 19999900000)
+TaskHeap<Task>               capture 56B: 600.112 ns/task, 1.00001 allocations/task (sum 19999900000)
+std::priority_queue<StdTask> capture 128B: 676.662 ns/task, 2.00009 allocations/task (sum 19999900000)
+TaskHeap<Task>               capture 128B: 701.765 ns/task, 1.00001 allocations/task (sum 19999900000)
+The capture sizes are the whole closure, including the &sum reference. Both types
+store a 16 byte capture inline. Up to 48 bytes a Task still costs no allocation,
+while std::function pays one on push and one more for the copy out of top(). One
+pointer past the buffer both allocate, and the cache misses of sifting 200k tasks
+dominate the time.
+-------------------------------------------------------------*/
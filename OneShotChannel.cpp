@@ -0,0 +1,393 @@
+/* One-shot channel: a lighter promise/future pair
+std::promise.cpp hands one value to another thread with std::promise/std::future:
+the shared state is heap allocated for every pair, reference counted, and guarded
+by a mutex and a condition variable. oneshot::Sender/Receiver do the same
+handoff with one 32-bit atomic state word:
+    Empty -> Ready            send() before the receiver waits: no syscall at all
+    Empty -> Waiting -> Ready the receiver went to sleep on the word (futex),
+                              send() sees Waiting and issues one FUTEX_WAKE
+    Empty/Waiting -> Closed   the Sender was dropped without a value; recv()
+                              throws broken_promise like std::future::get()
+The state itself does not need the heap:
+    - oneshot::make_channel<T>() takes a Slot from a per-type pool (thread-local
+      cache of free slots, refilled from and spilled to a shared list in batches),
+      and returns it there when both ends are gone
+    - oneshot::InlineChannel<T> keeps the Slot in the receiver's own frame, e.g.
+      on the stack of the waiting function; only a Sender pointing at it travels.
+      Its destructor waits until the sender has finished
+The wake after publishing Ready may run after the receiver has already returned
+and released the slot; FUTEX_WAKE_PRIVATE only uses the address as a key, so that
+is harmless.
+*/
+#include <iostream>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <optional>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <utility>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace futex {
+    // std::atomic<std::uint32_t> is layout compatible with uint32_t on Linux targets
+    inline void wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+    inline void wake(std::atomic<std::uint32_t>& word, int count) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+}
+
+namespace oneshot {
+
+template<typename T> class Sender;
+template<typename T> class Receiver;
+template<typename T> class InlineChannel;
+template<typename T> class SlotPool;
+
+template<typename T>
+class Slot {
+    public:
+        static constexpr std::uint32_t Empty = 0, Waiting = 1, Ready = 2, Closed = 3, Taken = 4;
+
+        Slot() = default;
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+        ~Slot() { reset(); }
+
+        template<typename... Args>
+        void send(Args&&... args) {
+            ::new (static_cast<void*>(m_storage)) T(std::forward<Args>(args)...);
+            publish(Ready);
+        }
+        void close() { publish(Closed); }
+        bool ready() const {
+            return m_state.load(std::memory_order_acquire) >= Ready;
+        }
+        void wait() {
+            // Spinning only pays off when the sender runs on another core
+            static const int spins = std::thread::hardware_concurrency() > 1 ? 128 : 0;
+            for (int i = 0; i < spins; ++i) {
+                if (ready()) return;
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+            }
+            auto state = Empty;
+            if (m_state.compare_exchange_strong(state, Waiting, std::memory_order_acquire)) {
+                state = Waiting;
+            }
+            while (state == Waiting) {
+                futex::wait(m_state, Waiting);
+                state = m_state.load(std::memory_order_acquire);
+            }
+        }
+        T take() {
+            wait();
+            if (m_state.load(std::memory_order_relaxed) == Closed) {
+                throw std::future_error(std::future_errc::broken_promise);
+            }
+            T& stored = *std::launder(reinterpret_cast<T*>(m_storage));
+            T value = std::move(stored);
+            stored.~T();
+            m_state.store(Taken, std::memory_order_relaxed);
+            return value;
+        }
+        // Back to Empty for reuse; destroys a value nobody took
+        void reset() {
+            if (m_state.load(std::memory_order_acquire) == Ready) {
+                std::launder(reinterpret_cast<T*>(m_storage))->~T();
+            }
+            m_state.store(Empty, std::memory_order_relaxed);
+        }
+    private:
+        friend class Sender<T>;
+        friend class Receiver<T>;
+        friend class SlotPool<T>;
+        template<typename U> friend std::pair<Sender<U>, Receiver<U>> make_channel();
+
+        void publish(std::uint32_t final) {
+            if (m_state.exchange(final, std::memory_order_acq_rel) == Waiting) {
+                futex::wake(m_state, 1);
+            }
+        }
+        // Pooled slots: freed when both the sender and the receiver let go
+        void release() {
+            if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) SlotPool<T>::put(this);
+        }
+
+        std::atomic<std::uint32_t> m_state{Empty};
+        std::atomic<std::uint32_t> m_refs{0};   // 0 for inline slots
+        Slot* m_nextFree = nullptr;
+        alignas(T) unsigned char m_storage[sizeof(T)];
+};
+
+template<typename T>
+class SlotPool {
+        using Slot = oneshot::Slot<T>;
+    public:
+        static Slot* get() {
+            auto& cache = local();
+            if (cache.empty()) refill(cache);
+            Slot* slot = cache.back();
+            cache.pop_back();
+            return slot;
+        }
+        static void put(Slot* slot) {
+            slot->reset();
+            auto& cache = local();
+            cache.push_back(slot);
+            if (cache.size() >= 2 * Batch) spill(cache);
+        }
+    private:
+        static constexpr std::size_t Batch = 32;
+        struct Shared {
+            std::mutex mutex;
+            Slot* head = nullptr;
+        };
+        // Leaked on purpose: slots may be released by threads that outlive main()
+        static Shared& shared() {
+            static Shared* s = new Shared;
+            return *s;
+        }
+        struct Cache : std::vector<Slot*> {
+            ~Cache() { spill(*this, 0); }
+        };
+        static Cache& local() {
+            thread_local Cache cache;
+            return cache;
+        }
+        static void refill(std::vector<Slot*>& cache) {
+            {
+                std::lock_guard lock(shared().mutex);
+                while (shared().head && cache.size() < Batch) {
+                    cache.push_back(std::exchange(shared().head, shared().head->m_nextFree));
+                }
+            }
+            while (cache.size() < Batch) cache.push_back(new Slot);
+        }
+        static void spill(std::vector<Slot*>& cache, std::size_t keep = Batch) {
+            std::lock_guard lock(shared().mutex);
+            while (cache.size() > keep) {
+                cache.back()->m_nextFree = shared().head;
+                shared().head = cache.back();
+                cache.pop_back();
+            }
+        }
+};
+
+template<typename T>
+class Sender {
+    public:
+        Sender() = default;
+        Sender(Sender&& other) noexcept : m_slot(std::exchange(other.m_slot, nullptr)) {}
+        Sender& operator=(Sender&& other) noexcept {
+            if (this != &other) {
+                drop();
+                m_slot = std::exchange(other.m_slot, nullptr);
+            }
+            return *this;
+        }
+        ~Sender() { drop(); }
+
+        template<typename... Args>
+        void send(Args&&... args) {
+            auto* slot = std::exchange(m_slot, nullptr);
+            if (!slot) throw std::future_error(std::future_errc::promise_already_satisfied);
+            // An inline slot may be gone as soon as it is published: read the flag first
+            const bool pooled = slot->m_refs.load(std::memory_order_relaxed) != 0;
+            slot->send(std::forward<Args>(args)...);
+            if (pooled) slot->release();
+        }
+    private:
+        friend class InlineChannel<T>;
+        template<typename U> friend std::pair<Sender<U>, Receiver<U>> make_channel();
+        explicit Sender(Slot<T>* slot) : m_slot(slot) {}
+        void drop() {
+            if (auto* slot = std::exchange(m_slot, nullptr)) {
+                const bool pooled = slot->m_refs.load(std::memory_order_relaxed) != 0;
+                slot->close();
+                if (pooled) slot->release();
+            }
+        }
+        Slot<T>* m_slot = nullptr;
+};
+
+template<typename T>
+class Receiver {
+    public:
+        Receiver() = default;
+        Receiver(Receiver&& other) noexcept : m_slot(std::exchange(other.m_slot, nullptr)) {}
+        Receiver& operator=(Receiver&& other) noexcept {
+            if (this != &other) {
+                if (m_slot) m_slot->release();
+                m_slot = std::exchange(other.m_slot, nullptr);
+            }
+            return *this;
+        }
+        ~Receiver() { if (m_slot) m_slot->release(); }
+
+        bool ready() const { return m_slot->ready(); }
+        // Blocks until the value is there; one call only, like std::future::get()
+        T recv() {
+            auto* slot = std::exchange(m_slot, nullptr);
+            struct Release {
+                Slot<T>* slot;
+                ~Release() { slot->release(); }
+            } release{slot};
+            return slot->take();
+        }
+    private:
+        template<typename U> friend std::pair<Sender<U>, Receiver<U>> make_channel();
+        explicit Receiver(Slot<T>* slot) : m_slot(slot) {}
+        Slot<T>* m_slot = nullptr;
+};
+
+template<typename T>
+std::pair<Sender<T>, Receiver<T>> make_channel() {
+    auto* slot = SlotPool<T>::get();
+    slot->m_refs.store(2, std::memory_order_relaxed);
+    return {Sender<T>(slot), Receiver<T>(slot)};
+}
+
+template<typename T>
+class InlineChannel {
+    public:
+        InlineChannel() = default;
+        InlineChannel(const InlineChannel&) = delete;
+        InlineChannel& operator=(const InlineChannel&) = delete;
+        ~InlineChannel() { if (m_senderOut) m_slot.wait(); }
+
+        Sender<T> sender() {
+            m_senderOut = true;
+            return Sender<T>(&m_slot);
+        }
+        T recv() { return m_slot.take(); }
+        bool ready() const { return m_slot.ready(); }
+    private:
+        Slot<T> m_slot;
+        bool m_senderOut = false;
+};
+
+}   // namespace oneshot
+
+// Allocation counter for the benchmark
+static std::atomic<std::size_t> g_allocations{0};
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// The other thread receives a pointer to a "send this" function through a
+// mailbox and calls it; the mailbox is the same for every variant
+struct Mailbox {
+    void post(std::function<void()>* job) {
+        m_job.store(job, std::memory_order_release);
+        m_job.notify_one();
+    }
+    std::function<void()>* take() {
+        m_job.wait(nullptr, std::memory_order_acquire);
+        return m_job.exchange(nullptr, std::memory_order_acquire);
+    }
+    std::atomic<std::function<void()>*> m_job{nullptr};
+};
+
+template<typename Handoff>
+void bench(const char* name, Handoff handoff) {
+    constexpr int local = 1'000'000, crossThread = 100'000;
+    using Clock = std::chrono::steady_clock;
+    // Same thread: pure cost of creating, fulfilling and reading one pair
+    auto allocations = g_allocations.load();
+    auto start = Clock::now();
+    long sum = 0;
+    for (int i = 0; i < local; ++i) sum += handoff(i, [](std::function<void()>& send) { send(); });
+    const double localNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / local;
+    const double localAllocs = static_cast<double>(g_allocations.load() - allocations) / local;
+
+    Mailbox mailbox;
+    std::thread worker([&mailbox] {
+        for (int i = 0; i < crossThread; ++i) (*mailbox.take())();
+    });
+    start = Clock::now();
+    for (int i = 0; i < crossThread; ++i) {
+        sum += handoff(i, [&mailbox](std::function<void()>& send) { mailbox.post(&send); });
+    }
+    const double crossNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / crossThread;
+    worker.join();
+    std::cout << name << " | " << localNs << " | " << localAllocs << " | " << crossNs << " (sum " << sum << ")" << std::endl;
+}
+
+int main() {
+    {
+        auto [sender, receiver] = oneshot::make_channel<std::string>();
+        auto th = std::jthread([sender = std::move(sender)]() mutable {
+            sender.send("from thread");
+        });
+        std::cout << receiver.recv() << std::endl;
+    }
+    {
+        oneshot::InlineChannel<std::string> channel;   // state on this stack frame
+        auto th = std::jthread([sender = channel.sender()]() mutable {
+            sender.send("from thread, inline state");
+        });
+        std::cout << channel.recv() << std::endl;
+    }
+    try {
+        auto [sender, receiver] = oneshot::make_channel<int>();
+        { auto dropped = std::move(sender); }
+        receiver.recv();
+    } catch (const std::future_error& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    std::cout << "variant | same thread ns | allocations per handoff | cross-thread ns" << std::endl;
+    bench("std::promise/future ", [](int i, auto dispatch) {
+        std::promise<int> promise;
+        auto future = promise.get_future();
+        std::function<void()> send = [&promise, i] { promise.set_value(i); };
+        dispatch(send);
+        return future.get();
+    });
+    bench("oneshot pooled      ", [](int i, auto dispatch) {
+        auto [sender, receiver] = oneshot::make_channel<int>();
+        std::function<void()> send = [&sender, i] { sender.send(i); };
+        dispatch(send);
+        return receiver.recv();
+    });
+    bench("oneshot inline      ", [](int i, auto dispatch) {
+        oneshot::InlineChannel<int> channel;
+        auto sender = channel.sender();
+        std::function<void()> send = [&sender, i] { sender.send(i); };
+        dispatch(send);
+        return channel.recv();
+    });
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+from thread
+from thread, inline state
+Caught: std::future_error: Broken promise
+variant | same thread ns | allocations per handoff | cross-thread ns
+std::promise/future  | 317.603 | 2 | 3461.61 (sum 504999450000)
+oneshot pooled       | 48.9427 | 0 | 2767.41 (sum 504999450000)
+oneshot inline       | 42.7402 | 0 | 2932.22 (sum 504999450000)
+std::promise heap allocates its reference counted shared state for every pair (two
+allocations here); the one-shot channel reuses pooled slots or the caller's
+frame, so creating, fulfilling and reading one costs about 45 ns with no allocation.
+Cross-thread, each handoff needs two context switches on one core, which dominates
+all three; the receiver does not spin before sleeping when there is only one CPU.
+-------------------------------------------------------------*/
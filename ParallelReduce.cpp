@@ -0,0 +1,317 @@
+/*----------------------------------------------------------------------------------
+parallel_reduce and parallel_transform_reduce
+std::future.cpp sums an array with four std::async calls over fixed quarters, and
+computeSum returns std::accumulate(..., 0), an int, which overflows long before
+the long it is stored in does. par::parallel_reduce / parallel_transform_reduce
+take any contiguous range and work like std::reduce / std::transform_reduce:
+    - chunking: below 2 * MinGrain elements everything runs inline on the caller.
+      Above it, the range is cut into at most ChunksPerThread chunks per thread
+      (a little over-decomposition, so a slow core does not hold up the rest)
+      of at least MinGrain elements each. Options::grain fixes the chunk size
+    - chunks are claimed from an atomic counter by a persistent pool and the
+      calling thread; the pool's threads are started once, not per call
+    - partial results are combined in a fixed pairwise tree ordered by chunk
+      index, so which thread ran which chunk never changes the result. With a
+      given grain the scalar loop gives bit-identical results on every machine,
+      even for floats (the SIMD loop depends on the vector width)
+    - Options::simd = Simd::On runs the chunk loop on std::experimental::simd
+      vectors. The element is widened to the result type first (so int data
+      summed into long stays exact), then transform and op are applied lane
+      wise: they must accept simd values too (std::plus<>, generic lambdas)
+No identity element is needed: every chunk starts from its first element.
+(std::reduce(std::execution::par) in libstdc++ needs -ltbb.)
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <numeric>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <exception>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <unistd.h>
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#define PAR_HAS_SIMD 1
+#endif
+
+namespace par {
+
+enum class Simd { Off, On };
+struct Options {
+    std::size_t grain = 0;     // elements per chunk, 0 = chosen from size and cores
+    std::size_t threads = 0;   // 0 = all pool threads plus the caller
+    Simd simd = Simd::Off;
+};
+constexpr std::size_t MinGrain = 16 * 1024;
+constexpr std::size_t ChunksPerThread = 4;
+
+class ChunkPool {
+    public:
+        explicit ChunkPool(std::size_t workers) {
+            for (std::size_t i = 0; i < workers; ++i) {
+                m_threads.emplace_back([this] { workerLoop(); });
+            }
+        }
+        ~ChunkPool() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& thread : m_threads) thread.join();
+        }
+        ChunkPool(const ChunkPool&) = delete;
+        ChunkPool& operator=(const ChunkPool&) = delete;
+
+        std::size_t concurrency() const { return m_threads.size() + 1; }
+
+        // Calls body(i) for every i in [0, chunks) on up to `threads` threads
+        // including the caller, returns when all are done
+        template<typename Body>
+        void run(std::size_t chunks, std::size_t threads, Body& body) {
+            Job job([](void* ctx, std::size_t i) { (*static_cast<Body*>(ctx))(i); }, &body, chunks);
+            if (t_inPool || threads <= 1 || m_threads.empty()) {
+                work(job);   // nested call from a chunk, or nothing to share
+            } else {
+                std::lock_guard single(m_callMutex);
+                {
+                    std::lock_guard lock(m_mutex);
+                    job.helpersLeft = threads - 1;
+                    m_job = &job;
+                    ++m_generation;
+                }
+                m_wake.notify_all();
+                work(job);
+                std::unique_lock lock(m_mutex);
+                m_done.wait(lock, [&job] { return job.active == 0; });
+                m_job = nullptr;
+            }
+            if (job.error) std::rethrow_exception(job.error);
+        }
+        static ChunkPool& global() {
+            static ChunkPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+    private:
+        struct Job {
+            Job(void (*fn)(void*, std::size_t), void* ctx, std::size_t chunks) : fn(fn), ctx(ctx), chunks(chunks) {}
+            void (*fn)(void*, std::size_t);
+            void* ctx;
+            std::size_t chunks;
+            std::atomic<std::size_t> next{0};
+            std::size_t helpersLeft = 0;   // guarded by m_mutex
+            std::size_t active = 0;        // guarded by m_mutex
+            std::exception_ptr error;      // guarded by m_mutex
+        };
+        void work(Job& job) {
+            for (auto i = job.next.fetch_add(1, std::memory_order_relaxed); i < job.chunks;
+                 i = job.next.fetch_add(1, std::memory_order_relaxed)) {
+                try {
+                    job.fn(job.ctx, i);
+                } catch (...) {
+                    std::lock_guard lock(m_mutex);
+                    if (!job.error) job.error = std::current_exception();
+                    job.next.store(job.chunks, std::memory_order_relaxed);   // stop handing out chunks
+                }
+            }
+        }
+        void workerLoop() {
+            t_inPool = true;
+            std::uint64_t seen = 0;
+            std::unique_lock lock(m_mutex);
+            for (;;) {
+                m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop) return;
+                seen = m_generation;
+                Job* job = m_job;
+                if (!job || job->helpersLeft == 0) continue;
+                --job->helpersLeft;
+                ++job->active;
+                lock.unlock();
+                work(*job);
+                lock.lock();
+                if (--job->active == 0) m_done.notify_one();
+            }
+        }
+        inline static thread_local bool t_inPool = false;
+        std::mutex m_callMutex;   // one job at a time
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        Job* m_job = nullptr;
+        std::uint64_t m_generation = 0;
+        bool m_stop = false;
+        std::vector<std::thread> m_threads;
+};
+
+namespace detail {
+    template<typename T, typename V, typename BinaryOp, typename Transform>
+    T reduce_chunk(const V* p, std::size_t n, BinaryOp& op, Transform& tr) {
+        T acc = static_cast<T>(tr(p[0]));
+        for (std::size_t i = 1; i < n; ++i) acc = op(acc, tr(p[i]));
+        return acc;
+    }
+
+#ifdef PAR_HAS_SIMD
+    namespace stdx = std::experimental;
+
+    template<typename T, typename V, typename BinaryOp, typename Transform>
+    T reduce_chunk_simd(const V* p, std::size_t n, BinaryOp& op, Transform& tr) {
+        using Loaded = stdx::native_simd<V>;
+        constexpr std::size_t W = Loaded::size();
+        using Wide = stdx::fixed_size_simd<T, W>;
+        if (n < 2 * W) return reduce_chunk<T>(p, n, op, tr);
+        auto load = [p](std::size_t i) { return stdx::static_simd_cast<Wide>(Loaded(p + i, stdx::element_aligned)); };
+        Wide acc = tr(load(0));
+        std::size_t i = W;
+        for (; i + W <= n; i += W) acc = op(acc, tr(load(i)));
+        T result = stdx::reduce(acc, op);
+        for (; i < n; ++i) result = op(result, tr(static_cast<T>(p[i])));
+        return result;
+    }
+#endif
+
+    template<typename T, typename V, typename BinaryOp, typename Transform>
+    T transform_reduce(const V* data, std::size_t n, T init, BinaryOp op, Transform tr, Options options) {
+        if (n == 0) return init;
+        auto chunkReduce = [&op, &tr, simd = options.simd](const V* p, std::size_t count) -> T {
+#ifdef PAR_HAS_SIMD
+            if constexpr (std::is_arithmetic_v<V> && std::is_arithmetic_v<T>) {
+                if (simd == Simd::On) return reduce_chunk_simd<T>(p, count, op, tr);
+            }
+#endif
+            (void)simd;
+            return reduce_chunk<T>(p, count, op, tr);
+        };
+        auto& pool = ChunkPool::global();
+        const auto threads = options.threads ? std::min(options.threads, pool.concurrency()) : pool.concurrency();
+        std::size_t chunks;
+        if (options.grain) {
+            chunks = (n + options.grain - 1) / options.grain;
+        } else {
+            chunks = n < 2 * MinGrain ? 1 : std::min((n + MinGrain - 1) / MinGrain, threads * ChunksPerThread);
+        }
+        if (chunks == 1) return op(init, chunkReduce(data, n));
+
+        const auto chunkSize = (n + chunks - 1) / chunks;
+        chunks = (n + chunkSize - 1) / chunkSize;
+        std::vector<T> partial(chunks);
+        auto body = [&](std::size_t i) {
+            const auto begin = i * chunkSize;
+            partial[i] = chunkReduce(data + begin, std::min(chunkSize, n - begin));
+        };
+        pool.run(chunks, threads, body);
+        // Fixed tree: (0+1)+(2+3), then ((0+1)+(2+3))+((4+5)+(6+7)), ...
+        for (std::size_t stride = 1; stride < chunks; stride *= 2) {
+            for (std::size_t i = 0; i + stride < chunks; i += 2 * stride) {
+                partial[i] = op(partial[i], partial[i + stride]);
+            }
+        }
+        return op(init, partial[0]);
+    }
+}
+
+template<std::contiguous_iterator It, typename T, typename BinaryOp, typename Transform>
+T parallel_transform_reduce(It first, It last, T init, BinaryOp op, Transform tr, Options options = {}) {
+    return detail::transform_reduce(std::to_address(first), static_cast<std::size_t>(last - first),
+                                    std::move(init), std::move(op), std::move(tr), options);
+}
+template<std::contiguous_iterator It, typename T, typename BinaryOp = std::plus<>>
+T parallel_reduce(It first, It last, T init, BinaryOp op = {}, Options options = {}) {
+    return parallel_transform_reduce(first, last, std::move(init), std::move(op), std::identity{}, options);
+}
+
+}   // namespace par
+
+long computeSum(const std::vector<int>& data, size_t start, size_t end) {
+    return std::accumulate(data.begin() + start, data.begin() + end, 0L);
+}
+long fourWaySum(const std::vector<int>& data) {
+    size_t partSize = data.size() / 4;
+    std::future<long> sum1 = std::async(std::launch::async, computeSum, std::cref(data), 0, partSize);
+    std::future<long> sum2 = std::async(std::launch::async, computeSum, std::cref(data), partSize, 2 * partSize);
+    std::future<long> sum3 = std::async(std::launch::async, computeSum, std::cref(data), 2 * partSize, 3 * partSize);
+    std::future<long> sum4 = std::async(std::launch::async, computeSum, std::cref(data), 3 * partSize, data.size());
+    return sum1.get() + sum2.get() + sum3.get() + sum4.get();
+}
+
+// Microseconds per call, repeated until at least 50 ms have been spent
+template<typename F>
+double us_per_call(F f, long& result) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    long calls = 0;
+    do {
+        result = f();
+        ++calls;
+    } while (Clock::now() - start < std::chrono::milliseconds(50));
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / calls;
+}
+
+int main() {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(1, 100);
+
+    // Deterministic floating point: same bits no matter how threads interleave
+    {
+        std::vector<float> values(3'000'000);
+        for (auto& v : values) v = static_cast<float>(dist(rng)) / 7.0f;
+        const float first = par::parallel_reduce(values.begin(), values.end(), 0.0f);
+        bool same = true;
+        for (int run = 0; run < 10; ++run) {
+            same &= par::parallel_reduce(values.begin(), values.end(), 0.0f) == first;
+        }
+        const double squares = par::parallel_transform_reduce(values.begin(), values.end(), 0.0, std::plus<>{},
+            [](auto x) { return x * x; }, {.simd = par::Simd::On});
+        std::cout << "float sum " << first << (same ? " (identical in 10 runs)" : " (differs between runs!)")
+                  << ", sum of squares (SIMD) " << squares << std::endl;
+    }
+
+    const auto availableBytes = static_cast<double>(sysconf(_SC_AVPHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+    std::cout << "elements | four-way std::async us | std::reduce(par) us | parallel_reduce us | parallel_reduce SIMD us" << std::endl;
+    for (double size = 1e3; size <= 1e9; size *= 10) {
+        const auto n = static_cast<std::size_t>(size);
+        if (n * sizeof(int) > availableBytes / 2) {
+            std::cout << n << " | skipped, needs " << n * sizeof(int) / 1e9 << " GB" << std::endl;
+            continue;
+        }
+        std::vector<int> data(n);
+        for (auto& num : data) num = dist(rng);
+        long a = 0, b = 0, c = 0, d = 0;
+        const double fourWay = us_per_call([&] { return fourWaySum(data); }, a);
+        const double stdPar = us_per_call([&] { return std::reduce(std::execution::par, data.begin(), data.end(), 0L); }, b);
+        const double ours = us_per_call([&] { return par::parallel_reduce(data.begin(), data.end(), 0L); }, c);
+        const double simd = us_per_call([&] {
+            return par::parallel_reduce(data.begin(), data.end(), 0L, std::plus<>{}, {.simd = par::Simd::On});
+        }, d);
+        if (a != b || b != c || c != d) std::cout << "results differ!" << std::endl;
+        std::cout << n << " | " << fourWay << " | " << stdPar << " | " << ours << " | " << simd << std::endl;
+    }
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+float sum 2.1649e+07 (identical in 10 runs), sum of squares (SIMD) 2.07219e+08
+elements | four-way std::async us | std::reduce(par) us | parallel_reduce us | parallel_reduce SIMD us
+1000 | 67.1589 | 2.12879 | 0.688229 | 0.368496
+10000 | 65.244 | 4.96295 | 6.5439 | 3.21539
+100000 | 137.792 | 35.7029 | 65.4374 | 32.386
+1000000 | 727.838 | 337.418 | 633.711 | 317.876
+10000000 | 8956.31 | 3759.59 | 6530.46 | 3505.65
+100000000 | 81775.8 | 65613.1 | 77482.5 | 62614.6
+1000000000 | skipped, needs 4 GB
+The four-way split pays for starting four threads on every call, which dominates
+up to 10^6 elements. Small inputs never leave the calling thread. The scalar
+int -> long loop is not vectorized by g++ -O2; the SIMD loop is, and is on par
+with or ahead of TBB's std::reduce. At 10^8 all of them are limited by memory
+bandwidth. 10^9 ints did not fit in the sandbox memory.
+-------------------------------------------------------------*/
@@ -0,0 +1,288 @@
+/*----------------------------------------------------------------------------------
+Read-optimized decorator: RCU snapshot and seqlock
+MultiThreadedAnimalProxy (DecoratorWrapper.cpp) takes the same exclusive mutex in
+getName() and setName(). With thousands of reads per write, the readers serialize
+on that mutex and bounce its cache line between cores for nothing.
+RcuAnimalProxy keeps the mutex only for writers. After every setName() the writer
+publishes an immutable snapshot of getName() through an atomic pointer, so readers
+just load the pointer and copy the string without taking any lock:
+    - setName stays linearizable: the new snapshot is published before it returns
+    - old snapshots are reclaimed with a tiny epoch scheme. A reader announces the
+      epoch it runs in, the writer swaps the pointer, advances the epoch and waits
+      until no reader is still inside an older epoch before deleting
+Seqlock<T> covers trivially copyable state: readers copy the value optimistically
+and retry if the sequence number was odd or changed while they were copying.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <stdexcept>
+
+// Abstract Interface to inherit
+class AnimalWithName {
+    public:
+        virtual ~AnimalWithName() = default;
+    public:
+        virtual void setName(const std::string& name) = 0;
+        virtual std::string getName() const = 0;
+};
+// Implementation without protection against concurrency
+class DogWithName : public AnimalWithName {
+    public:
+        void setName(const std::string& name) override {
+            m_name = name;
+        }
+        std::string getName() const override {
+            return "Dog_" + m_name;
+        }
+    private:
+        std::string m_name;
+};
+// Baseline from DecoratorWrapper.cpp
+class MultiThreadedAnimalProxy : public AnimalWithName {
+    public:
+        MultiThreadedAnimalProxy(std::unique_ptr<AnimalWithName> animal) : m_animal(std::move(animal))
+        {}
+    public:
+        void setName(const std::string& name) override {
+            auto lock = std::lock_guard {m_mutex};
+            m_animal->setName(name);
+        }
+        std::string getName() const override {
+            auto lock = std::lock_guard {m_mutex};
+            return m_animal->getName();
+        }
+    private:
+        std::unique_ptr<AnimalWithName> m_animal;
+        mutable std::mutex m_mutex;
+};
+
+// Minimal epoch-based reclamation. Every reader thread owns one padded slot that
+// holds the epoch it entered (0 = not reading)
+class EpochDomain {
+    public:
+        static constexpr std::size_t MaxThreads = 256;
+
+        class ReadGuard {
+            public:
+                explicit ReadGuard(EpochDomain& domain) : m_slot(domain.slot()) {
+                    // Acquire: seeing the epoch a synchronize() advanced to implies seeing the
+                    // pointer swapped before it, because that writer will not wait for this slot
+                    m_slot.store(domain.m_epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+                }
+                ~ReadGuard() {
+                    m_slot.store(0, std::memory_order_release);
+                }
+                ReadGuard(const ReadGuard&) = delete;
+                ReadGuard& operator=(const ReadGuard&) = delete;
+            private:
+                std::atomic<std::uint64_t>& m_slot;
+        };
+
+        // Waits until every reader that might still see memory retired before this
+        // call has left its critical section
+        void synchronize() {
+            const auto old = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            for (auto& s : m_slots) {
+                for (;;) {
+                    const auto e = s.epoch.load(std::memory_order_seq_cst);
+                    if (e == 0 || e > old) break;
+                    std::this_thread::yield();
+                }
+            }
+        }
+    private:
+        struct alignas(64) Slot {
+            std::atomic<std::uint64_t> epoch{0};
+        };
+        std::atomic<std::uint64_t>& slot() {
+            return m_slots[thread_slot_index()].epoch;
+        }
+        // Dense index per live reader thread, recycled when the thread exits. The
+        // table is trivially destructible, so thread exit after a domain is gone is
+        // safe. Past MaxThreads live readers a read fails with std::runtime_error;
+        // the claim is retried on that thread's next read
+        static std::size_t thread_slot_index() {
+            static std::array<std::atomic<bool>, MaxThreads> used{};
+            struct Claim {
+                std::size_t index = MaxThreads;
+                Claim() {
+                    for (std::size_t i = 0; i < MaxThreads; ++i) {
+                        bool expected = false;
+                        if (used[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                            index = i;
+                            return;
+                        }
+                    }
+                    throw std::runtime_error("EpochDomain: more than MaxThreads reader threads");
+                }
+                ~Claim() { used[index].store(false, std::memory_order_release); }
+            };
+            thread_local Claim claim;
+            return claim.index;
+        }
+    private:
+        std::atomic<std::uint64_t> m_epoch{1};
+        std::array<Slot, MaxThreads> m_slots;
+};
+
+// Lock-free reads, mutex-serialized writes
+class RcuAnimalProxy : public AnimalWithName {
+    public:
+        RcuAnimalProxy(std::unique_ptr<AnimalWithName> animal)
+            : m_animal(std::move(animal)), m_snapshot(new std::string(m_animal->getName()))
+        {}
+        ~RcuAnimalProxy() override {
+            delete m_snapshot.load();
+        }
+    public:
+        void setName(const std::string& name) override {
+            auto lock = std::lock_guard {m_writeMutex};
+            m_animal->setName(name);
+            auto* fresh = new std::string(m_animal->getName());
+            auto* old = m_snapshot.exchange(fresh, std::memory_order_seq_cst);
+            m_domain.synchronize();
+            delete old;
+        }
+        std::string getName() const override {
+            auto guard = EpochDomain::ReadGuard{m_domain};
+            return *m_snapshot.load(std::memory_order_seq_cst);
+        }
+    private:
+        std::unique_ptr<AnimalWithName> m_animal;
+        std::atomic<std::string*> m_snapshot;
+        std::mutex m_writeMutex;
+        mutable EpochDomain m_domain;
+};
+
+// Seqlock for trivially copyable values. The payload is stored as relaxed atomic
+// words so the optimistic copy is not a data race
+template<typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock requires a trivially copyable type");
+    static constexpr std::size_t Words = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+    public:
+        explicit Seqlock(const T& value = T{}) { store(value); }
+        // Single writer at a time; wrap in a mutex if there are several
+        void store(const T& value) {
+            std::array<std::uint64_t, Words> buffer{};
+            std::memcpy(buffer.data(), &value, sizeof(T));
+            const auto seq = m_seq.load(std::memory_order_relaxed);
+            m_seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t i = 0; i < Words; ++i) {
+                m_words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+            m_seq.store(seq + 2, std::memory_order_release);
+        }
+        T load() const {
+            std::array<std::uint64_t, Words> buffer;
+            for (;;) {
+                const auto before = m_seq.load(std::memory_order_acquire);
+                if (before & 1) continue;
+                for (std::size_t i = 0; i < Words; ++i) {
+                    buffer[i] = m_words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (m_seq.load(std::memory_order_relaxed) == before) break;
+            }
+            T value;
+            std::memcpy(&value, buffer.data(), sizeof(T));
+            return value;
+        }
+    private:
+        std::atomic<std::uint64_t> m_seq{0};
+        std::array<std::atomic<std::uint64_t>, Words> m_words{};
+};
+
+struct Position {
+    double x;
+    double y;
+    std::uint64_t version;
+};
+
+// Runs `readers` reader threads against one writer that updates every 100us and
+// returns the aggregate read throughput
+template<typename ReadOp, typename WriteOp>
+double reads_per_second(int readers, ReadOp readOp, WriteOp writeOp) {
+    constexpr auto duration = std::chrono::milliseconds(100);
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> total{0};
+    std::vector<std::jthread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            std::uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                readOp();
+                ++local;
+            }
+            total.fetch_add(local);
+        });
+    }
+    threads.emplace_back([&] {
+        int i = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            writeOp(i++);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    threads.clear();
+    return static_cast<double>(total.load()) / std::chrono::duration<double>(duration).count();
+}
+
+int main() {
+    RcuAnimalProxy animal(std::make_unique<DogWithName>());
+    auto th = std::thread([&animal](){
+        auto name = animal.getName();
+        std::cout << "The name: " << name << std::endl;
+    });
+    animal.setName("Harry");
+    th.join();
+    std::cout << "After write: " << animal.getName() << std::endl;
+
+    Seqlock<Position> position{{1.0, 2.0, 0}};
+    position.store({3.0, 4.0, 1});
+    auto p = position.load();
+    std::cout << "Position: " << p.x << "," << p.y << " v" << p.version << std::endl;
+
+    // Benchmark: reader threads scaled against one writer
+    MultiThreadedAnimalProxy mutexProxy(std::make_unique<DogWithName>());
+    RcuAnimalProxy rcuProxy(std::make_unique<DogWithName>());
+    std::cout << "readers | mutex reads/s | rcu reads/s | seqlock reads/s" << std::endl;
+    for (int readers : {1, 2, 4, 8, 16}) {
+        const auto m = reads_per_second(readers,
+            [&] { return mutexProxy.getName(); },
+            [&](int i) { mutexProxy.setName("Rex" + std::to_string(i)); });
+        const auto r = reads_per_second(readers,
+            [&] { return rcuProxy.getName(); },
+            [&](int i) { rcuProxy.setName("Rex" + std::to_string(i)); });
+        const auto s = reads_per_second(readers,
+            [&] { return position.load(); },
+            [&](int i) { position.store({1.0 * i, 2.0 * i, static_cast<std::uint64_t>(i)}); });
+        std::cout << readers << " | " << m << " | " << r << " | " << s << std::endl;
+    }
+    return 0;
+}
+
+/*------------- Output (1 core sandbox, g++ -O2) -------------
+The name: Dog_Harry
+After write: Dog_Harry
+Position: 3,4 v1
+readers | mutex reads/s | rcu reads/s | seqlock reads/s
+1 | 2.93768e+07 | 6.76053e+07 | 6.40547e+08
+2 | 3.15939e+07 | 6.85529e+07 | 4.45151e+08
+4 | 3.47725e+07 | 7.20065e+07 | 4.10583e+08
+8 | 3.00719e+07 | 7.55592e+07 | 6.7447e+08
+16 | 3.11349e+07 | 8.86228e+07 | 7.16406e+08
+-------------------------------------------------------------*/
@@ -0,0 +1,398 @@
+/*----------------------------------------------------------------------------------
+Lazy task<T> with symmetric transfer
+async_task in C++20.cpp suspends at its start and nobody ever resumes it (the
+"result" printed is the default 0 unless the body happened to run), and it blocks
+in sleep_for inside the body; MyCoroutine in Coroutines.cpp never destroys its
+handle. coro::task<T> is the usual building block instead:
+    - lazy: calling a task coroutine only creates the frame; it starts when it
+      is co_awaited (or passed to sync_wait) and the task object owns the frame
+    - co_await task stores the awaiting coroutine as the task's continuation and
+      returns the task's handle from await_suspend; when the task finishes, its
+      final awaiter returns the continuation. Returning a handle from
+      await_suspend is symmetric transfer: the compiler jumps to the next
+      coroutine as a tail call, so a chain of a million nested co_awaits runs in
+      constant stack, where resuming with handle.resume() nests one C++ stack
+      frame per level. Clang always emits that tail call; GCC only in optimized
+      builds without sanitizers, so debug builds run the long chains shorter
+    - an exception escaping a task is stored in its promise and rethrown from
+      the co_await (or from sync_wait) in the awaiting coroutine
+    - coro::sync_wait(task) starts a task from ordinary code and blocks until it
+      completes, also when it finishes on another thread
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <variant>
+#include <optional>
+#include <utility>
+#include <type_traits>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+
+namespace coro {
+
+template<typename T = void> class task;
+
+namespace detail {
+    struct PromiseBase {
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) const noexcept {
+                return finished.promise().continuation;
+            }
+            void await_resume() const noexcept {}
+        };
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr error;
+    };
+
+    template<typename T>
+    struct Promise : PromiseBase {
+        task<T> get_return_object() noexcept;
+        template<typename U = T>
+        void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+        T get() {
+            if (error) std::rethrow_exception(error);
+            return std::move(*result);
+        }
+        std::optional<T> result;
+    };
+
+    template<>
+    struct Promise<void> : PromiseBase {
+        task<void> get_return_object() noexcept;
+        void return_void() noexcept {}
+        void get() {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+}
+
+template<typename T>
+class [[nodiscard]] task {
+    public:
+        using promise_type = detail::Promise<T>;
+
+        task(task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        task& operator=(task&& other) noexcept {
+            if (this != &other) {
+                if (m_handle) m_handle.destroy();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+        ~task() { if (m_handle) m_handle.destroy(); }
+
+        auto operator co_await() noexcept {
+            struct Awaiter {
+                std::coroutine_handle<promise_type> handle;
+                bool await_ready() const noexcept { return handle.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+                    handle.promise().continuation = awaiting;
+                    return handle;   // start the task on this thread, no stack growth
+                }
+                T await_resume() const { return handle.promise().get(); }
+            };
+            return Awaiter{m_handle};
+        }
+    private:
+        friend struct detail::Promise<T>;
+        explicit task(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+        std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace detail {
+    template<typename T>
+    task<T> Promise<T>::get_return_object() noexcept {
+        return task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+    }
+    inline task<void> Promise<void>::get_return_object() noexcept {
+        return task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+    }
+
+    // Set by the finishing thread under the mutex, so the waiter may destroy it
+    // as soon as wait() returns
+    class Signal {
+        public:
+            void set() {
+                std::lock_guard lock(m_mutex);
+                m_done = true;
+                m_cv.notify_one();
+            }
+            void wait() {
+                std::unique_lock lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_done; });
+            }
+        private:
+            std::mutex m_mutex;
+            std::condition_variable m_cv;
+            bool m_done = false;
+    };
+
+    class SyncWaitTask {
+        public:
+            struct promise_type {
+                Signal* signal = nullptr;
+                SyncWaitTask get_return_object() noexcept {
+                    return SyncWaitTask(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+                std::suspend_always initial_suspend() const noexcept { return {}; }
+                auto final_suspend() const noexcept {
+                    struct Notify {
+                        bool await_ready() const noexcept { return false; }
+                        void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+                            handle.promise().signal->set();
+                        }
+                        void await_resume() const noexcept {}
+                    };
+                    return Notify{};
+                }
+                void return_void() const noexcept {}
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+            SyncWaitTask(SyncWaitTask&&) = delete;
+            ~SyncWaitTask() { m_handle.destroy(); }
+            void run(Signal& signal) {
+                m_handle.promise().signal = &signal;
+                m_handle.resume();
+                signal.wait();
+            }
+        private:
+            explicit SyncWaitTask(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+            std::coroutine_handle<promise_type> m_handle;
+    };
+
+    template<typename T>
+    using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    template<typename T>
+    SyncWaitTask syncWaitBody(task<T>& work, std::variant<std::monostate, Stored<T>, std::exception_ptr>& out) {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await work;
+                out.template emplace<1>();
+            } else {
+                out.template emplace<1>(co_await work);
+            }
+        } catch (...) {
+            out.template emplace<2>(std::current_exception());
+        }
+    }
+}
+
+template<typename T>
+T sync_wait(task<T> work) {
+    std::variant<std::monostate, detail::Stored<T>, std::exception_ptr> out;
+    detail::Signal signal;
+    detail::syncWaitBody(work, out).run(signal);
+    if (out.index() == 2) std::rethrow_exception(std::get<2>(out));
+    if constexpr (!std::is_void_v<T>) return std::move(std::get<1>(out));
+}
+
+}   // namespace coro
+
+// Counts allocations for the benchmark
+static std::atomic<std::size_t> g_allocations{0};
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+coro::task<int> example_coroutine() {
+    std::cout << "Coroutine started!" << std::endl;
+    co_return 42;
+}
+coro::task<int> risky_task() {
+    throw std::runtime_error("An error occured during computation!");
+    co_return 0;
+}
+coro::task<int> wraps_risky_task() {
+    co_return 1 + co_await risky_task();   // the exception passes through here
+}
+// Resumes the awaiting coroutine on a new thread, like simple_awaiter in Coroutines.cpp
+struct resume_on_new_thread {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+        std::thread([handle] { handle.resume(); }).detach();
+    }
+    void await_resume() const noexcept {}
+};
+coro::task<std::thread::id> hop() {
+    co_await resume_on_new_thread{};
+    co_return std::this_thread::get_id();
+}
+
+// Stack used by a chain: distance between the caller's frame and the deepest level
+static const char* g_leafFrame = nullptr;
+[[gnu::noinline]] static void markLeaf() {
+    g_leafFrame = static_cast<const char*>(__builtin_frame_address(0));
+}
+
+coro::task<int> chain(int n) {
+    if (n == 0) {
+        markLeaf();
+        co_return 0;
+    }
+    co_return 1 + co_await chain(n - 1);
+}
+
+// The same chain without symmetric transfer: await_suspend resumes the child
+// with handle.resume() and continues the parent once it returns
+class nested_task {
+    public:
+        struct promise_type {
+            int value = 0;
+            nested_task get_return_object() noexcept {
+                return nested_task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_always final_suspend() const noexcept { return {}; }
+            void return_value(int v) noexcept { value = v; }
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+        nested_task(nested_task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        ~nested_task() { if (m_handle) m_handle.destroy(); }
+        auto operator co_await() noexcept {
+            struct Awaiter {
+                std::coroutine_handle<promise_type> handle;
+                bool await_ready() const noexcept { return false; }
+                bool await_suspend(std::coroutine_handle<>) const {
+                    handle.resume();   // runs to completion one C++ frame deeper
+                    return false;
+                }
+                int await_resume() const noexcept { return handle.promise().value; }
+            };
+            return Awaiter{m_handle};
+        }
+        int run() {
+            m_handle.resume();
+            return m_handle.promise().value;
+        }
+    private:
+        explicit nested_task(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+        std::coroutine_handle<promise_type> m_handle;
+};
+nested_task nested_chain(int n) {
+    if (n == 0) {
+        markLeaf();
+        co_return 0;
+    }
+    co_return 1 + co_await nested_chain(n - 1);
+}
+
+// Continuation-passing style: each level hands a callback to the next one
+void callback_chain(int n, const std::function<void(int)>& done) {
+    if (n == 0) {
+        markLeaf();
+        done(0);
+        return;
+    }
+    callback_chain(n - 1, [&done](int v) { done(v + 1); });
+}
+
+[[gnu::noinline]] int plain_chain(int n) {
+    if (n == 0) {
+        markLeaf();
+        return 0;
+    }
+    int below = plain_chain(n - 1);
+    asm volatile("" : "+r"(below));   // keep it a real call, not a loop
+    return below + 1;
+}
+
+static volatile int g_sink;
+
+// GCC turns symmetric transfer into a real tail call only when optimizing and not
+// instrumenting; elsewhere a million nested co_awaits would overflow the stack
+#if defined(__OPTIMIZE__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+constexpr int DeepChain = 1'000'000;
+#else
+constexpr int DeepChain = 10'000;
+#endif
+
+template<typename Run>
+void measure(const char* name, int depth, Run run) {
+    // Stack used by one chain
+    const char* top = static_cast<const char*>(__builtin_frame_address(0));
+    g_sink = run(depth);
+    const long stackBytes = static_cast<long>(top - g_leafFrame);
+    // Per-hop cost: repeat shorter chains of the same depth
+    constexpr long hops = 10'000'000;
+    const long repeats = std::max<long>(1, hops / depth);
+    const auto allocations = g_allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < repeats; ++i) g_sink = run(depth);
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << " | " << depth << " | " << stackBytes << " | " << ns / (repeats * depth) << " | "
+              << static_cast<double>(g_allocations.load() - allocations) / (repeats * depth) << std::endl;
+}
+
+int main() {
+    const int result = coro::sync_wait(example_coroutine());
+    std::cout << "Coroutine result: " << result << std::endl;
+    try {
+        coro::sync_wait(wraps_risky_task());
+    } catch (const std::exception& e) {
+        std::cout << "Caught exception: " << e.what() << std::endl;
+    }
+    const auto finishedOn = coro::sync_wait(hop());
+    std::cout << "Task finished on another thread: " << std::boolalpha << (finishedOn != std::this_thread::get_id()) << std::endl;
+    std::cout << "Chain of " << DeepChain << " co_awaits: " << coro::sync_wait(chain(DeepChain)) << std::endl;
+
+    std::cout << "approach | depth | stack bytes | ns per hop | allocations per hop" << std::endl;
+    for (int depth : {10, 1'000, 10'000}) {
+        measure("plain recursion", depth, plain_chain);
+        measure("callbacks (std::function)", depth, [](int n) {
+            int out = 0;
+            callback_chain(n, [&out](int v) { out = v; });
+            return out;
+        });
+        measure("nested resume()", depth, [](int n) { return nested_chain(n).run(); });
+        measure("task<T> symmetric transfer", depth, [](int n) { return coro::sync_wait(chain(n)); });
+    }
+    measure("task<T> symmetric transfer", DeepChain, [](int n) { return coro::sync_wait(chain(n)); });
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Coroutine started!
+Coroutine result: 42
+Caught exception: An error occured during computation!
+Task finished on another thread: true
+Chain of 1000000 co_awaits: 1000000
+approach | depth | stack bytes | ns per hop | allocations per hop
+plain recursion | 10 | 272 | 2.0129 | 0
+callbacks (std::function) | 10 | 912 | 11.5596 | 0
+nested resume() | 10 | 560 | 47.3634 | 1.1
+task<T> symmetric transfer | 10 | 432 | 63.0827 | 1.2
+plain recursion | 1000 | 16112 | 13.2257 | 0
+callbacks (std::function) | 1000 | 64272 | 39.2471 | 0
+nested resume() | 1000 | 32240 | 77.0906 | 1.001
+task<T> symmetric transfer | 1000 | 432 | 69.4381 | 1.002
+plain recursion | 10000 | 160112 | 13.3374 | 0
+callbacks (std::function) | 10000 | 640272 | 37.5042 | 0
+nested resume() | 10000 | 320240 | 86.8196 | 1.0001
+task<T> symmetric transfer | 10000 | 432 | 73.9439 | 1.0002
+task<T> symmetric transfer | 1000000 | 432 | 93.518 | 1
+Stack bytes is the distance from the caller to the deepest level. With symmetric
+transfer, task<T> stays at 432 bytes at any depth, including the million-level chain.
+Nested resume() and callbacks grow 32 and 64 bytes per level, and the plain
+recursion grows 16. Each co_await hop costs about one frame allocation plus an
+indirect jump, 55-75 ns here. The callback chain avoids allocations because its
+capture fits in std::function's small buffer, but it pays with stack on the way down
+and back up.
+-------------------------------------------------------------*/
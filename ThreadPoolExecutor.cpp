@@ -0,0 +1,329 @@
+/*----------------------------------------------------------------------------------
+Fixed thread-pool executor
+std::async(std::launch::async, ...) in FuturesAndAsync.cpp starts a new OS thread
+for every call (libstdc++ does, and so do most other implementations), and its
+std::future shares a separately allocated state with it. For short tasks the
+thread start costs far more than the task.
+pool::ThreadPool keeps a fixed set of worker threads:
+    - submit(f, args...) returns a pool::Future<R>. The task, its arguments and the
+      result slot are one allocation with an intrusive reference count; get()
+      spins briefly and then sleeps in std::atomic::wait, and rethrows exceptions
+      like std::future::get()
+    - the queue is a bounded ring: submit() blocks while it is full (backpressure
+      instead of unbounded memory growth), try_submit() returns std::nullopt
+    - the destructor runs whatever is still queued, then joins the workers
+Migrating: replace std::async(std::launch::async, f, args...) with
+pool::async(f, args...) (uses ThreadPool::global()) and std::future<T> with
+pool::Future<T>, or keep `auto`. Tasks that sleep or block hold a worker hostage;
+the pool is meant for CPU work, a blocking task on a pool worker that waits for
+another queued task can deadlock.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <variant>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace pool {
+
+namespace detail {
+    struct Job {
+        virtual void run() = 0;
+        virtual ~Job() = default;
+    };
+
+    template<typename T>
+    struct State : Job {
+        using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+        static constexpr std::uint32_t Pending = 0, Ready = 1;
+
+        void release() {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+        }
+        void wait() {
+            for (int i = 0; i < 256; ++i) {
+                if (status.load(std::memory_order_acquire) == Ready) return;
+            }
+            status.wait(Pending, std::memory_order_acquire);
+        }
+        std::atomic<std::uint32_t> status{Pending};
+        std::atomic<std::uint32_t> refs{2};   // the queue and the Future
+        std::variant<std::monostate, Value, std::exception_ptr> result;
+    };
+
+    template<typename T, typename F>
+    struct Task final : State<T> {
+        explicit Task(F&& f) : fn(std::move(f)) {}
+        void run() override {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    std::invoke(std::move(fn));
+                    this->result.template emplace<1>();
+                } else {
+                    this->result.template emplace<1>(std::invoke(std::move(fn)));
+                }
+            } catch (...) {
+                this->result.template emplace<2>(std::current_exception());
+            }
+            this->status.store(State<T>::Ready, std::memory_order_release);
+            this->status.notify_all();
+            this->release();
+        }
+        F fn;
+    };
+}
+
+template<typename T>
+class Future {
+    public:
+        Future() = default;
+        explicit Future(detail::State<T>* state) : m_state(state) {}
+        Future(Future&& other) noexcept : m_state(std::exchange(other.m_state, nullptr)) {}
+        Future& operator=(Future&& other) noexcept {
+            if (this != &other) {
+                if (m_state) m_state->release();
+                m_state = std::exchange(other.m_state, nullptr);
+            }
+            return *this;
+        }
+        ~Future() { if (m_state) m_state->release(); }
+
+        bool valid() const { return m_state != nullptr; }
+        bool is_ready() const {
+            return m_state->status.load(std::memory_order_acquire) == detail::State<T>::Ready;
+        }
+        void wait() const { m_state->wait(); }
+        // Like std::future::get(): one call, then the future is no longer valid
+        T get() {
+            if (!m_state) throw std::future_error(std::future_errc::no_state);
+            m_state->wait();
+            auto* state = std::exchange(m_state, nullptr);
+            if (state->result.index() == 2) {
+                auto error = std::get<2>(state->result);
+                state->release();
+                std::rethrow_exception(error);
+            }
+            if constexpr (std::is_void_v<T>) {
+                state->release();
+            } else {
+                T value = std::move(std::get<1>(state->result));
+                state->release();
+                return value;
+            }
+        }
+    private:
+        detail::State<T>* m_state = nullptr;
+};
+
+class ThreadPool {
+    public:
+        explicit ThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()),
+                            std::size_t queueCapacity = 1024)
+            : m_ring(std::max<std::size_t>(1, queueCapacity))
+        {
+            for (std::size_t i = 0; i < std::max<std::size_t>(1, threads); ++i) {
+                m_workers.emplace_back([this] { run(); });
+            }
+        }
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
+            }
+            m_notEmpty.notify_all();
+            for (auto& worker : m_workers) worker.join();
+        }
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Blocks while the queue is full
+        template<typename F, typename... Args>
+        auto submit(F&& f, Args&&... args) {
+            auto [future, job] = makeTask(std::forward<F>(f), std::forward<Args>(args)...);
+            std::unique_lock lock(m_mutex);
+            m_notFull.wait(lock, [this] { return m_count < m_ring.size(); });
+            push(job, lock);
+            return std::move(future);
+        }
+        // Returns std::nullopt instead of blocking when the queue is full
+        template<typename F, typename... Args>
+        auto try_submit(F&& f, Args&&... args) {
+            using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+            std::unique_lock lock(m_mutex);
+            if (m_count == m_ring.size()) return std::optional<Future<R>>{};
+            auto [future, job] = makeTask(std::forward<F>(f), std::forward<Args>(args)...);
+            push(job, lock);
+            return std::optional<Future<R>>{std::move(future)};
+        }
+        std::size_t threads() const { return m_workers.size(); }
+
+        static ThreadPool& global() {
+            static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()), 4096);
+            return pool;
+        }
+    private:
+        template<typename F, typename... Args>
+        static auto makeTask(F&& f, Args&&... args) {
+            using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+            auto bound = std::bind_front(std::forward<F>(f), std::forward<Args>(args)...);
+            auto* task = new detail::Task<R, decltype(bound)>(std::move(bound));
+            return std::pair<Future<R>, detail::Job*>{Future<R>(task), task};
+        }
+        void push(detail::Job* job, std::unique_lock<std::mutex>& lock) {
+            m_ring[(m_head + m_count) % m_ring.size()] = job;
+            ++m_count;
+            lock.unlock();
+            m_notEmpty.notify_one();
+        }
+        void run() {
+            for (;;) {
+                detail::Job* job;
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_notEmpty.wait(lock, [this] { return m_stop || m_count != 0; });
+                    if (m_count == 0) return;   // stopping and drained
+                    job = m_ring[m_head];
+                    m_head = (m_head + 1) % m_ring.size();
+                    --m_count;
+                }
+                m_notFull.notify_one();
+                job->run();
+            }
+        }
+        std::mutex m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+        std::vector<detail::Job*> m_ring;
+        std::size_t m_head = 0;
+        std::size_t m_count = 0;
+        bool m_stop = false;
+        std::vector<std::thread> m_workers;
+};
+
+// Drop-in for std::async(std::launch::async, f, args...)
+template<typename F, typename... Args>
+requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+auto async(F&& f, Args&&... args) {
+    return ThreadPool::global().submit(std::forward<F>(f), std::forward<Args>(args)...);
+}
+template<typename F, typename... Args>
+auto async(ThreadPool& executor, F&& f, Args&&... args) {
+    return executor.submit(std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+}   // namespace pool
+
+int compute_square(int x) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // Simulate Heavy Computation
+    return x * x;
+}
+int risky_task() {
+    throw std::runtime_error("An error occured during computation!");
+}
+int process_data(int id) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return id * id;
+}
+
+void spin_for(std::chrono::nanoseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {}
+}
+
+// Runs n tasks of the given length and returns the wall time in seconds
+template<typename Launch>
+double run_tasks(int n, std::chrono::nanoseconds length, Launch launch) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<decltype(launch([length] { spin_for(length); return 1; }))> futures;
+    futures.reserve(n);
+    for (int i = 0; i < n; ++i) futures.push_back(launch([length] { spin_for(length); return 1; }));
+    int done = 0;
+    for (auto& f : futures) done += f.get();
+    if (done != n) std::cout << "lost tasks!" << std::endl;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    // FuturesAndAsync.cpp, migrated
+    {
+        pool::Future<int> async_result = pool::async(compute_square, 10);
+        std::cout << "Doing other work..." << std::endl;
+        std::cout << "The square of 10 is: " << async_result.get() << std::endl;
+    }
+    try {
+        pool::Future<int> result = pool::async(risky_task);
+        result.get();  // This will throw exception
+    } catch (const std::exception& e) {
+        std::cout << "Caught exception: " << e.what() << std::endl;
+    }
+    {
+        // process_data blocks in sleep_for, so give it its own pool of 5 threads
+        pool::ThreadPool io(5);
+        std::vector<int> ids = {1, 2, 3, 4, 5};
+        std::vector<pool::Future<int>> futures;
+        for (int id : ids) {
+            futures.push_back(pool::async(io, process_data, id));
+        }
+        for (auto& fut : futures) {
+            std::cout << "Processed result: " << fut.get() << std::endl;
+        }
+    }
+    // Backpressure: one worker, room for 4 queued tasks
+    {
+        pool::ThreadPool small(1, 4);
+        std::vector<pool::Future<void>> accepted;
+        int rejected = 0;
+        for (int i = 0; i < 20; ++i) {
+            if (auto f = small.try_submit(spin_for, std::chrono::milliseconds(1))) {
+                accepted.push_back(std::move(*f));
+            } else {
+                ++rejected;
+            }
+        }
+        for (auto& f : accepted) f.get();
+        std::cout << "try_submit: " << accepted.size() << " accepted, " << rejected << " rejected" << std::endl;
+    }
+
+    using namespace std::chrono_literals;
+    const double cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "task length | std::async tasks/s | pool tasks/s | std::async overhead us/task | pool overhead us/task" << std::endl;
+    for (auto length : {1000ns, 10'000ns, 100'000ns, 1'000'000ns}) {
+        const int n = static_cast<int>(std::clamp<long long>(200'000'000 / length.count(), 200, 20'000));
+        const double ideal = n * std::chrono::duration<double>(length).count() / cores;
+        const double a = run_tasks(n, length, [](auto f) { return std::async(std::launch::async, f); });
+        const double p = run_tasks(n, length, [](auto f) { return pool::async(f); });
+        std::cout << length.count() / 1000 << " us | " << n / a << " | " << n / p
+                  << " | " << (a - ideal) / n * 1e6 << " | " << (p - ideal) / n * 1e6 << std::endl;
+    }
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Doing other work...
+The square of 10 is: 100
+Caught exception: An error occured during computation!
+Processed result: 1
+Processed result: 4
+Processed result: 9
+Processed result: 16
+Processed result: 25
+try_submit: 4 accepted, 16 rejected
+task length | std::async tasks/s | pool tasks/s | std::async overhead us/task | pool overhead us/task
+1 us | 20427.9 | 412075 | 47.9528 | 1.42674
+10 us | 18581.5 | 77508.2 | 43.8169 | 2.90187
+100 us | 6574.59 | 9704.85 | 52.1007 | 3.04125
+1000 us | 983.274 | 993.617 | 17.0106 | 6.42425
+Overhead is wall time minus the pure task time, per task. std::async pays about
+50 us for the thread it starts; at 1 ms tasks that is lost in the task itself.
+-------------------------------------------------------------*/
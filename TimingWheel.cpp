@@ -0,0 +1,371 @@
+/*---------------------------------------------------------------------------------
+Hierarchical timing wheel
+WatchdogTimer.cpp arms alarm() (one per process), Coroutines.cpp and
+FuturesAndAsync.cpp block a whole thread in sleep_for to wait for a delay. With
+hundreds of thousands of pending timeouts neither scales, and a sorted container
+pays O(log n) per timer.
+TimerWheel keeps timers in 4 levels of 256 slots (like the Linux kernel timers):
+    - level 0 holds the timers due within the next 256 ticks, one slot per tick;
+      level 1 the next 256 * 256 ticks, 256 ticks per slot, and so on. Timers
+      beyond 2^32 ticks wait in an overflow list
+    - schedule_at() links the timer into one slot (O(1)), cancel() unlinks it from
+      its doubly linked slot list (O(1)). Timers live in a pooled node table and
+      are addressed by {index, generation}, so a stale TimerId cancels nothing
+    - advance() steps the wheel tick by tick. When a lower level wraps around, the
+      matching slot of the level above is cascaded: its timers move down one level
+      (every timer moves at most 3 times). Then the level 0 slot is fired
+Periodic timers are re-armed after each run. TimerService drives one wheel from a
+single thread (1 ms ticks by default); callbacks run on that thread without the
+lock held, so they may schedule and cancel timers themselves.
+----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+class TimerWheel {
+    public:
+        using Callback = std::function<void()>;
+        struct TimerId {
+            std::uint32_t index = UINT32_MAX;
+            std::uint32_t generation = 0;
+        };
+        static constexpr unsigned Levels = 4;
+        static constexpr unsigned SlotBits = 8;
+        static constexpr unsigned Slots = 1u << SlotBits;
+
+        explicit TimerWheel(std::uint64_t startTick = 0) : m_now(startTick) {
+            std::fill(std::begin(m_heads), std::end(m_heads), Nil);
+        }
+        std::uint64_t now() const { return m_now; }
+        std::size_t size() const { return m_size; }
+
+        // Due at `tick` (at least the next one), then every `period` ticks if non zero
+        TimerId schedule_at(std::uint64_t tick, Callback fn, std::uint64_t period = 0) {
+            std::uint32_t index;
+            if (m_free != Nil) {
+                index = m_free;
+                m_free = m_nodes[index].next;
+            } else {
+                index = static_cast<std::uint32_t>(m_nodes.size());
+                m_nodes.emplace_back();
+            }
+            auto& node = m_nodes[index];
+            node.expiry = std::max(tick, m_now + 1);
+            node.period = period;
+            node.fn = std::move(fn);
+            node.state = State::Armed;
+            link(index);
+            ++m_size;
+            return {index, node.generation};
+        }
+        // True if this prevented a future run of the timer
+        bool cancel(TimerId id) {
+            if (id.index >= m_nodes.size()) return false;
+            auto& node = m_nodes[id.index];
+            if (node.generation != id.generation) return false;
+            switch (node.state) {
+                case State::Armed:
+                    unlink(id.index);
+                    release(id.index);
+                    return true;
+                case State::Firing:
+                    node.state = State::Cancelled;   // do not re-arm after this run
+                    return node.period != 0;
+                default:
+                    return false;
+            }
+        }
+        // Moves the wheel to `tick`, handing every expired callback to invoke(fn).
+        // Returns the number of callbacks run
+        template<typename Invoke>
+        std::size_t advance(std::uint64_t tick, Invoke invoke) {
+            std::size_t fired = 0;
+            while (m_now < tick) {
+                ++m_now;
+                if ((m_now & 0xFFFF'FFFFu) == 0) cascade(Overflow);
+                unsigned top = 0;
+                while (top + 1 < Levels && (m_now & ((std::uint64_t{1} << (SlotBits * (top + 1))) - 1)) == 0) ++top;
+                for (unsigned level = top; level >= 1; --level) {
+                    cascade(level * Slots + ((m_now >> (SlotBits * level)) & (Slots - 1)));
+                }
+                const auto head = static_cast<std::size_t>(m_now & (Slots - 1));
+                while (m_heads[head] != Nil) {
+                    const auto index = m_heads[head];
+                    prefetch(m_nodes[index].next);
+                    unlink(index);
+                    m_nodes[index].state = State::Firing;
+                    Callback fn = std::move(m_nodes[index].fn);
+                    invoke(fn);   // may schedule: do not hold a Node& across it
+                    ++fired;
+                    auto& node = m_nodes[index];
+                    if (node.state == State::Firing && node.period != 0) {
+                        node.fn = std::move(fn);
+                        node.expiry = m_now + node.period;
+                        node.state = State::Armed;
+                        link(index);
+                    } else {
+                        release(index);
+                    }
+                }
+            }
+            return fired;
+        }
+        std::size_t advance(std::uint64_t tick) {
+            return advance(tick, [](Callback& fn) { fn(); });
+        }
+    private:
+        static constexpr std::uint32_t Nil = UINT32_MAX;
+        static constexpr std::size_t Overflow = Levels * Slots;
+        enum class State : std::uint8_t { Free, Armed, Firing, Cancelled };
+        struct Node {
+            std::uint64_t expiry = 0;
+            std::uint64_t period = 0;
+            Callback fn;
+            std::uint32_t prev = Nil, next = Nil;   // next doubles as the free list link
+            std::uint32_t generation = 0;
+            std::uint32_t head = 0;                 // slot list the node is linked into
+            State state = State::Free;
+        };
+        // The level is the highest byte in which expiry and now differ, the slot is
+        // that byte of expiry
+        void link(std::uint32_t index) {
+            auto& node = m_nodes[index];
+            const auto diff = node.expiry ^ m_now;
+            const auto level = diff == 0 ? 0u : static_cast<unsigned>(std::bit_width(diff) - 1) / SlotBits;
+            node.head = level >= Levels ? Overflow
+                : level * Slots + ((node.expiry >> (SlotBits * level)) & (Slots - 1));
+            node.prev = Nil;
+            node.next = m_heads[node.head];
+            if (node.next != Nil) m_nodes[node.next].prev = index;
+            m_heads[node.head] = index;
+        }
+        void unlink(std::uint32_t index) {
+            auto& node = m_nodes[index];
+            if (node.prev != Nil) m_nodes[node.prev].next = node.next;
+            else m_heads[node.head] = node.next;
+            if (node.next != Nil) m_nodes[node.next].prev = node.prev;
+        }
+        void release(std::uint32_t index) {
+            auto& node = m_nodes[index];
+            node.fn = nullptr;
+            node.state = State::Free;
+            ++node.generation;
+            node.next = m_free;
+            m_free = index;
+            --m_size;
+        }
+        // Slot lists are in no memory order, fetch the next node while handling this one
+        void prefetch(std::uint32_t index) const {
+            if (index != Nil) __builtin_prefetch(&m_nodes[index]);
+        }
+        void cascade(std::size_t head) {
+            auto index = std::exchange(m_heads[head], Nil);
+            while (index != Nil) {
+                const auto next = m_nodes[index].next;
+                prefetch(next);
+                link(index);
+                index = next;
+            }
+        }
+        std::uint64_t m_now;
+        std::uint32_t m_heads[Levels * Slots + 1];
+        std::vector<Node> m_nodes;
+        std::uint32_t m_free = Nil;
+        std::size_t m_size = 0;
+};
+
+class TimerService {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using TimerId = TimerWheel::TimerId;
+
+        explicit TimerService(Clock::duration tick = std::chrono::milliseconds(1))
+            : m_tick(tick), m_epoch(Clock::now()), m_thread([this] { run(); })
+        {}
+        ~TimerService() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_one();
+        }
+        TimerService(const TimerService&) = delete;
+        TimerService& operator=(const TimerService&) = delete;
+
+        // Never fires early: the due tick is rounded up
+        TimerId schedule_after(Clock::duration delay, TimerWheel::Callback fn) {
+            return schedule(delay, std::move(fn), 0);
+        }
+        TimerId schedule_every(Clock::duration period, TimerWheel::Callback fn) {
+            return schedule(period, std::move(fn), std::max<std::uint64_t>(1, ticks(period)));
+        }
+        bool cancel(TimerId id) {
+            std::lock_guard lock(m_mutex);
+            return m_wheel.cancel(id);
+        }
+    private:
+        std::uint64_t ticks(Clock::duration d) const {
+            return static_cast<std::uint64_t>((d + m_tick - Clock::duration(1)) / m_tick);
+        }
+        TimerId schedule(Clock::duration delay, TimerWheel::Callback fn, std::uint64_t period) {
+            const auto due = ticks(Clock::now() - m_epoch + delay);
+            bool wasEmpty;
+            TimerId id;
+            {
+                std::lock_guard lock(m_mutex);
+                wasEmpty = m_wheel.size() == 0;
+                id = m_wheel.schedule_at(due, std::move(fn), period);
+            }
+            if (wasEmpty) m_cv.notify_one();   // the timer thread sleeps without a deadline
+            return id;
+        }
+        void run() {
+            std::unique_lock lock(m_mutex);
+            while (!m_stop) {
+                if (m_wheel.size() == 0) {
+                    m_cv.wait(lock, [this] { return m_stop || m_wheel.size() != 0; });
+                    continue;
+                }
+                const auto current = static_cast<std::uint64_t>((Clock::now() - m_epoch) / m_tick);
+                m_wheel.advance(current, [&lock](TimerWheel::Callback& fn) {
+                    lock.unlock();
+                    fn();
+                    lock.lock();
+                });
+                m_cv.wait_until(lock, m_epoch + m_tick * static_cast<Clock::rep>(m_wheel.now() + 1),
+                                [this] { return m_stop; });
+            }
+        }
+        const Clock::duration m_tick;
+        const Clock::time_point m_epoch;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        TimerWheel m_wheel;
+        bool m_stop = false;
+        std::jthread m_thread;   // last: joined before the wheel goes away
+};
+
+// Baseline: the usual sorted timer set, cancel by iterator
+using TimerMap = std::multimap<std::uint64_t, std::function<void()>>;
+
+template<typename F>
+double ns_per(std::size_t n, F f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+}
+
+void bench(std::size_t n) {
+    std::mt19937 rng{11};
+    std::uniform_int_distribution<std::uint64_t> far{1, 1u << 20};
+    std::uniform_int_distribution<std::uint64_t> near{1, 1u << 16};
+    std::vector<std::uint64_t> cancelDelays(n), fireDelays(n);
+    for (auto& d : cancelDelays) d = far(rng);
+    for (auto& d : fireDelays) d = near(rng);
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    std::uint64_t fired = 0;
+
+    TimerWheel wheel;
+    std::vector<TimerWheel::TimerId> ids(n);
+    TimerMap map;
+    std::vector<TimerMap::iterator> its(n);
+    std::cout << "insert ns | wheel " << ns_per(n, [&] {
+        for (std::size_t i = 0; i < n; ++i) ids[i] = wheel.schedule_at(cancelDelays[i], [&fired] { ++fired; });
+    }) << " | multimap " << ns_per(n, [&] {
+        for (std::size_t i = 0; i < n; ++i) its[i] = map.emplace(cancelDelays[i], [&fired] { ++fired; });
+    }) << std::endl;
+    std::cout << "cancel ns | wheel " << ns_per(n, [&] {
+        for (auto i : order) wheel.cancel(ids[i]);
+    }) << " | multimap " << ns_per(n, [&] {
+        for (auto i : order) map.erase(its[i]);
+    }) << std::endl;
+
+    for (std::size_t i = 0; i < n; ++i) wheel.schedule_at(wheel.now() + fireDelays[i], [&fired] { ++fired; });
+    for (std::size_t i = 0; i < n; ++i) map.emplace(fireDelays[i], [&fired] { ++fired; });
+    const auto end = wheel.now() + (1u << 16);
+    std::cout << "fire ns   | wheel " << ns_per(n, [&] {
+        wheel.advance(end);
+    }) << " | multimap " << ns_per(n, [&] {
+        for (std::uint64_t tick = 1; tick <= (1u << 16); ++tick) {
+            while (!map.empty() && map.begin()->first <= tick) {
+                map.begin()->second();
+                map.erase(map.begin());
+            }
+        }
+    }) << " (" << fired << " fired)" << std::endl;
+}
+
+int main() {
+    using namespace std::chrono_literals;
+    TimerService timers;
+
+    // WatchdogTimer.cpp without alarm(): any number of watchdogs, no signals
+    for (int i = 1; i <= 3; i++) {
+        auto watchdog = timers.schedule_after(50ms, [i] { std::cout << "Iteration " << i << ": watchdog fired!\n"; });
+        std::cout << "Iteration " << i << ": Watchdog timer set for 50 ms.\n";
+        std::this_thread::sleep_for(i < 3 ? 20ms : 80ms);   // the last one overruns
+        if (timers.cancel(watchdog)) std::cout << "Iteration " << i << " Watchdog timer cleared.\n";
+    }
+    {
+        std::atomic<int> ticks{0};
+        auto heartbeat = timers.schedule_every(10ms, [&ticks] { ticks.fetch_add(1); });
+        std::this_thread::sleep_for(105ms);
+        timers.cancel(heartbeat);
+        std::cout << "Periodic 10 ms timer ran " << ticks.load() << " times in 105 ms\n";
+    }
+
+    // 100k timeouts on one timer thread
+    constexpr int timeouts = 100'000;
+    std::atomic<int> remaining{timeouts};
+    std::atomic<std::int64_t> totalLateUs{0}, maxLateUs{0};
+    std::mt19937 rng{5};
+    std::uniform_int_distribution<int> delayMs{1, 200};
+    for (int i = 0; i < timeouts; ++i) {
+        const auto delay = std::chrono::milliseconds(delayMs(rng));
+        const auto due = std::chrono::steady_clock::now() + delay;
+        timers.schedule_after(delay, [&, due] {
+            const auto late = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - due).count();
+            totalLateUs.fetch_add(late, std::memory_order_relaxed);
+            auto seen = maxLateUs.load(std::memory_order_relaxed);
+            while (late > seen && !maxLateUs.compare_exchange_weak(seen, late)) {}
+            if (remaining.fetch_sub(1) == 1) remaining.notify_one();
+        });
+    }
+    for (auto left = remaining.load(); left != 0; left = remaining.load()) remaining.wait(left);
+    std::cout << timeouts << " timeouts on 1 timer thread: mean lateness " << totalLateUs.load() / timeouts
+              << " us, max " << maxLateUs.load() << " us (1 ms ticks)" << std::endl;
+
+    bench(1'000'000);
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Iteration 1: Watchdog timer set for 50 ms.
+Iteration 1 Watchdog timer cleared.
+Iteration 2: Watchdog timer set for 50 ms.
+Iteration 2 Watchdog timer cleared.
+Iteration 3: Watchdog timer set for 50 ms.
+Iteration 3: watchdog fired!
+Periodic 10 ms timer ran 10 times in 105 ms
+100000 timeouts on 1 timer thread: mean lateness 1303 us, max 10536 us (1 ms ticks)
+insert ns | wheel 87.5518 | multimap 1068.75
+cancel ns | wheel 88.0498 | multimap 448.134
+fire ns   | wheel 195.186 | multimap 129.626 (2000000 fired)
+Insert and cancel stay flat with 10^6 pending timers. Firing costs the wheel more
+than walking a sorted map, because most timers are cascaded once before they run;
+a timer that is cancelled before it expires (the usual fate of a timeout) never
+pays for that. The lateness includes the main thread competing for the one core.
+-------------------------------------------------------------*/
@@ -0,0 +1,243 @@
+/*----------------------------------------------------------------------------------
+Type-sorted polymorphic collection
+A std::vector<std::unique_ptr<Base>> scatters objects all over the heap and, when
+the dynamic types are interleaved, every virtual call jumps to a different target.
+The branch predictor keeps missing and the instruction cache keeps reloading the
+bodies of the overrides.
+PolyCollection<Base> keeps one contiguous segment (a std::vector<Derived>) per
+dynamic type. Iterating it walks the segments one after another, so all calls to
+the same override run back to back in one tight batch:
+    - for_each(f)              - f(Base&), still a virtual call but always the same target
+    - for_each<T1, T2...>(f)   - f(T&) for the listed types, fully devirtualized when
+                                 the types are final; other segments fall back to f(Base&)
+Elements are ordered by type, not by insertion order; both for_each overloads visit
+the segments in the order their types were first inserted. References returned by
+emplace() are invalidated when their segment grows, exactly like std::vector.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <random>
+#include <chrono>
+#include <typeindex>
+#include <unordered_map>
+#include <type_traits>
+#include <concepts>
+
+template<typename Base>
+class PolyCollection {
+    private:
+        // Type-erased view on one segment: first Base subobject and the distance
+        // between two consecutive elements (sizeof(Derived))
+        struct SegmentView {
+            std::byte* first;
+            std::size_t stride;
+            std::size_t size;
+        };
+        struct ISegment {
+            explicit ISegment(std::type_index type) : m_type(type) {}
+            virtual ~ISegment() = default;
+            virtual SegmentView view() = 0;
+            const std::type_index m_type;   // dynamic type of the elements
+        };
+        template<typename Derived>
+        struct Segment : ISegment {
+            Segment() : ISegment(typeid(Derived)) {}
+            SegmentView view() override {
+                if (m_items.empty()) {
+                    return {nullptr, sizeof(Derived), 0};
+                }
+                auto* base = static_cast<Base*>(m_items.data());
+                return {reinterpret_cast<std::byte*>(base), sizeof(Derived), m_items.size()};
+            }
+            std::vector<Derived> m_items;
+        };
+    public:
+        template<std::derived_from<Base> Derived, typename... Args>
+        Derived& emplace(Args&&... args) {
+            return segment<Derived>().m_items.emplace_back(std::forward<Args>(args)...);
+        }
+        template<std::derived_from<Base> Derived>
+        void reserve(std::size_t count) {
+            segment<Derived>().m_items.reserve(count);
+        }
+        std::size_t size() const {
+            std::size_t total = 0;
+            for (const auto& seg : m_segments) {
+                total += seg->view().size;
+            }
+            return total;
+        }
+        // Generic iteration through the Base interface, one segment at a time
+        template<typename F>
+        void for_each(F&& f) {
+            for (const auto& seg : m_segments) {
+                const auto v = seg->view();
+                for (std::size_t i = 0; i < v.size; ++i) {
+                    f(*std::launder(reinterpret_cast<Base*>(v.first + i * v.stride)));
+                }
+            }
+        }
+        // Restituted iteration: segments of the listed types are visited with their
+        // static type, so the compiler sees the exact override to call
+        template<typename... Known, typename F>
+        requires (sizeof...(Known) > 0)
+        void for_each(F&& f) {
+            for (const auto& seg : m_segments) {
+                if (!(visit_as<Known>(*seg, f) || ...)) {
+                    const auto v = seg->view();
+                    for (std::size_t i = 0; i < v.size; ++i) {
+                        f(*std::launder(reinterpret_cast<Base*>(v.first + i * v.stride)));
+                    }
+                }
+            }
+        }
+    private:
+        template<typename Derived>
+        Segment<Derived>& segment() {
+            auto& slot = m_index[std::type_index(typeid(Derived))];
+            if (!slot) {
+                m_segments.push_back(std::make_unique<Segment<Derived>>());
+                slot = m_segments.back().get();
+            }
+            return static_cast<Segment<Derived>&>(*slot);
+        }
+        template<typename Derived, typename F>
+        static bool visit_as(ISegment& seg, F& f) {
+            if (seg.m_type != std::type_index(typeid(Derived))) {
+                return false;
+            }
+            for (auto& item : static_cast<Segment<Derived>&>(seg).m_items) {
+                f(item);
+            }
+            return true;
+        }
+    private:
+        std::vector<std::unique_ptr<ISegment>> m_segments;
+        std::unordered_map<std::type_index, ISegment*> m_index;   // lookup only, m_segments sets the order
+};
+
+// Same hierarchy as in std::optional.cpp, plus one more implementation
+template<typename T>
+class IValue {
+    public:
+        virtual ~IValue() = default;
+    public:
+        virtual T get() const = 0;
+};
+template<typename T>
+class RawValue final : public IValue<T> {
+    public:
+        explicit RawValue(T value) : m_value(std::move(value)) {}
+    public:
+        T get() const override {
+            return m_value;
+        }
+    private:
+        T m_value;
+};
+template<typename T>
+class OptionalValue final : public IValue<T> {
+    public:
+        explicit OptionalValue(std::optional<T> value) : m_value(std::move(value)) {}
+    public:
+        T get() const override {
+            return m_value.value();
+        }
+    private:
+        std::optional<T> m_value;
+};
+template<typename T>
+class ScaledValue final : public IValue<T> {
+    public:
+        ScaledValue(T value, T factor) : m_value(std::move(value)), m_factor(std::move(factor)) {}
+    public:
+        T get() const override {
+            return m_value * m_factor;
+        }
+    private:
+        T m_value;
+        T m_factor;
+};
+
+template<typename F>
+double measure_ms(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+    PolyCollection<IValue<int>> values;
+    values.emplace<RawValue<int>>(10);
+    values.emplace<OptionalValue<int>>(15);
+    values.emplace<RawValue<int>>(20);
+    values.for_each([](const IValue<int>& v) {
+        std::cout << v.get() << std::endl;
+    });
+
+    // Benchmark: sum of get() over randomly interleaved types
+    constexpr std::size_t count = 2'000'000;
+    constexpr int rounds = 10;
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> kind{0, 2};
+
+    std::vector<std::unique_ptr<IValue<int>>> pointers;
+    PolyCollection<IValue<int>> sorted;
+    pointers.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const int value = static_cast<int>(i % 100);
+        switch (kind(rng)) {
+            case 0:
+                pointers.push_back(std::make_unique<RawValue<int>>(value));
+                sorted.emplace<RawValue<int>>(value);
+                break;
+            case 1:
+                pointers.push_back(std::make_unique<OptionalValue<int>>(value));
+                sorted.emplace<OptionalValue<int>>(value);
+                break;
+            default:
+                pointers.push_back(std::make_unique<ScaledValue<int>>(value, 2));
+                sorted.emplace<ScaledValue<int>>(value, 2);
+                break;
+        }
+    }
+
+    long long sumPointers = 0, sumSorted = 0, sumRestituted = 0;
+    const double tPointers = measure_ms([&] {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& v : pointers) {
+                sumPointers += v->get();
+            }
+        }
+    });
+    const double tSorted = measure_ms([&] {
+        for (int r = 0; r < rounds; ++r) {
+            sorted.for_each([&](const IValue<int>& v) { sumSorted += v.get(); });
+        }
+    });
+    const double tRestituted = measure_ms([&] {
+        for (int r = 0; r < rounds; ++r) {
+            sorted.for_each<RawValue<int>, OptionalValue<int>, ScaledValue<int>>(
+                [&](const auto& v) { sumRestituted += v.get(); });
+        }
+    });
+
+    std::cout << "Elements: " << sorted.size() << ", rounds: " << rounds << std::endl;
+    std::cout << "vector<unique_ptr> interleaved : " << tPointers << " ms (sum " << sumPointers << ")\n";
+    std::cout << "PolyCollection virtual         : " << tSorted << " ms (sum " << sumSorted << ")\n";
+    std::cout << "PolyCollection restituted      : " << tRestituted << " ms (sum " << sumRestituted << ")\n";
+    return 0;
+}
+
+/*------------- Output (g++ -std=c++20 -O2) -------------------
+10
+20
+15
+Elements: 2000000, rounds: 10
+vector<unique_ptr> interleaved : 291.164 ms (sum 1320378390)
+PolyCollection virtual         : 71.5354 ms (sum 1320378390)
+PolyCollection restituted      : 27.6304 ms (sum 1320378390)
+-------------------------------------------------------------*/
@@ -0,0 +1,507 @@
+/*----------------------------------------------------------------------------------
+Work-stealing fork-join scheduler
+std::future.cpp splits computeSum into four std::async calls: four fixed parts, so
+one slow part keeps the others idle, and a part cannot split itself further.
+WorkStealingScheduler runs fork-join work on a fixed set of workers:
+    - every worker owns a Chase-Lev deque. It pushes and pops its own jobs at the
+      bottom without locks (LIFO, the hot end), idle workers steal the oldest job
+      from the top of a random victim with one CAS. The oldest job is usually the
+      biggest one, so a steal moves a lot of work at once
+    - join(a, b) pushes b as a job that lives on the caller's stack, runs a, then
+      pops b back and runs it inline unless somebody stole it, in which case it
+      helps with other work until b is done. No allocation, so recursion can
+      split down to small grains
+    - TaskGroup::spawn(f) / sync() for any number of children (heap-allocated jobs);
+      sync() also executes queued work while it waits
+    - a worker that found nothing to steal for a while parks on a futex. A push
+      onto an empty deque wakes one sleeper; the check costs one fence and a load
+      when nobody sleeps. Pushes onto a non-empty deque skip it: no worker goes to
+      sleep while it can see work
+run(f) hands a root job from any outside thread to the pool and waits for it.
+join/TaskGroup called outside the pool simply run serially.
+-----------------------------------------------------------------------------------*/
+#include <iostream>
+#include <array>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <exception>
+#include <random>
+#include <chrono>
+#include <future>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <climits>
+#include <utility>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace futex {
+    // std::atomic<std::uint32_t> is layout compatible with uint32_t on Linux targets
+    inline void wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+    inline void wake(std::atomic<std::uint32_t>& word, int count) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+}
+
+struct Job {
+    virtual void execute() = 0;
+    virtual ~Job() = default;
+};
+
+// Chase-Lev deque with the C11 orderings of Le, Pop, Cohen and Zappa Nardelli
+// ("Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013)
+class ChaseLevDeque {
+    public:
+        ChaseLevDeque() { m_array.store(grow(nullptr, 0, 0), std::memory_order_relaxed); }
+        ChaseLevDeque(const ChaseLevDeque&) = delete;
+        ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+        // Owner only; true if the deque looked empty before, which is when idle
+        // workers may need a wakeup (they do not sleep while any deque has work)
+        bool push(Job* job) {
+            const auto b = m_bottom.load(std::memory_order_relaxed);
+            const auto t = m_top.load(std::memory_order_acquire);
+            auto* array = m_array.load(std::memory_order_relaxed);
+            if (b - t > array->mask) {
+                array = grow(array, t, b);
+            }
+            array->at(b).store(job, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_release);
+            return b == t;
+        }
+        // Owner only
+        Job* pop() {
+            const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+            auto* array = m_array.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = m_top.load(std::memory_order_relaxed);
+            if (t > b) {
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            Job* job = array->at(b).load(std::memory_order_relaxed);
+            if (t == b) {
+                // Last job: race the thieves for it
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    job = nullptr;
+                }
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+        // Any thread; nullptr if empty or another thief won
+        Job* steal() {
+            auto t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto b = m_bottom.load(std::memory_order_acquire);
+            if (t >= b) return nullptr;
+            auto* array = m_array.load(std::memory_order_acquire);
+            Job* job = array->at(t).load(std::memory_order_relaxed);
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return job;
+        }
+        bool looks_empty() const {
+            return m_top.load(std::memory_order_relaxed) >= m_bottom.load(std::memory_order_relaxed);
+        }
+    private:
+        struct Ring {
+            explicit Ring(std::int64_t capacity) : mask(capacity - 1), items(new std::atomic<Job*>[capacity]) {}
+            std::atomic<Job*>& at(std::int64_t i) { return items[i & mask]; }
+            const std::int64_t mask;
+            std::unique_ptr<std::atomic<Job*>[]> items;
+        };
+        // Thieves may still read the old ring, so it is kept until the deque dies
+        Ring* grow(Ring* old, std::int64_t top, std::int64_t bottom) {
+            auto ring = std::make_unique<Ring>(old ? 2 * (old->mask + 1) : 1024);
+            for (auto i = top; i < bottom; ++i) {
+                ring->at(i).store(old->at(i).load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            auto* raw = ring.get();
+            m_rings.push_back(std::move(ring));
+            if (old) m_array.store(raw, std::memory_order_release);
+            return raw;
+        }
+        alignas(64) std::atomic<std::int64_t> m_top{0};
+        alignas(64) std::atomic<std::int64_t> m_bottom{0};
+        std::atomic<Ring*> m_array{nullptr};
+        std::vector<std::unique_ptr<Ring>> m_rings;
+};
+
+class WorkStealingScheduler {
+    public:
+        explicit WorkStealingScheduler(std::size_t workers = std::max(1u, std::thread::hardware_concurrency()))
+            : m_workers(std::max<std::size_t>(1, workers))
+        {
+            for (std::size_t i = 0; i < m_workers.size(); ++i) {
+                m_workers[i].rng.seed(static_cast<unsigned>(i * 7919 + 1));
+                m_threads.emplace_back([this, i] { workerLoop(i); });
+            }
+        }
+        ~WorkStealingScheduler() {
+            m_stop.store(true, std::memory_order_seq_cst);
+            m_epoch.fetch_add(1, std::memory_order_release);
+            futex::wake(m_epoch, INT_MAX);
+            for (auto& thread : m_threads) thread.join();
+        }
+        WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+        WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+        std::size_t workers() const { return m_workers.size(); }
+
+        // Runs f on a worker and blocks the calling thread until it is done
+        template<typename F>
+        auto run(F f) {
+            using R = std::invoke_result_t<F&>;
+            if constexpr (std::is_void_v<R>) {
+                runRoot(f);
+            } else {
+                std::optional<R> result;
+                runRoot([&] { result.emplace(f()); });
+                return std::move(*result);
+            }
+        }
+
+        // Runs a and b, possibly in parallel, and returns when both are done
+        template<typename A, typename B>
+        static void join(A&& a, B&& b) {
+            auto* self = t_scheduler;
+            if (!self) {
+                a();
+                b();
+                return;
+            }
+            StackJob<B&> jobB(b);
+            auto& deque = self->m_workers[t_index].deque;
+            if (deque.push(&jobB)) self->notify();
+            std::exception_ptr errorA;
+            try {
+                a();
+            } catch (...) {
+                errorA = std::current_exception();
+            }
+            // LIFO: everything a() pushed is gone, so this pops b unless it was stolen
+            if (deque.pop() == &jobB) {
+                jobB.execute();
+            } else {
+                self->helpUntil([&jobB] { return jobB.done.load(std::memory_order_acquire); });
+            }
+            if (errorA) std::rethrow_exception(errorA);
+            if (jobB.error) std::rethrow_exception(jobB.error);
+        }
+
+        class TaskGroup {
+            public:
+                TaskGroup() = default;
+                TaskGroup(const TaskGroup&) = delete;
+                TaskGroup& operator=(const TaskGroup&) = delete;
+                ~TaskGroup() { wait(); }
+
+                template<typename F>
+                void spawn(F&& f) {
+                    auto* self = t_scheduler;
+                    if (!self) {
+                        run(f);
+                        return;
+                    }
+                    m_pending.fetch_add(1, std::memory_order_relaxed);
+                    if (self->m_workers[t_index].deque.push(new HeapJob<std::decay_t<F>>(std::forward<F>(f), *this))) {
+                        self->notify();
+                    }
+                }
+                // Waits for every spawned job, rethrows the first exception
+                void sync() {
+                    wait();
+                    if (m_error) std::rethrow_exception(std::exchange(m_error, nullptr));
+                }
+            private:
+                template<typename F>
+                struct HeapJob final : Job {
+                    HeapJob(F&& f, TaskGroup& group) : fn(std::move(f)), group(group) {}
+                    HeapJob(const F& f, TaskGroup& group) : fn(f), group(group) {}
+                    void execute() override {
+                        group.run(fn);
+                        auto& g = group;
+                        delete this;
+                        g.m_pending.fetch_sub(1, std::memory_order_release);
+                    }
+                    F fn;
+                    TaskGroup& group;
+                };
+                template<typename F>
+                void run(F& f) {
+                    try {
+                        f();
+                    } catch (...) {
+                        std::lock_guard lock(m_errorMutex);
+                        if (!m_error) m_error = std::current_exception();
+                    }
+                }
+                void wait() {
+                    if (auto* self = t_scheduler) {
+                        self->helpUntil([this] { return m_pending.load(std::memory_order_acquire) == 0; });
+                    }
+                }
+                std::atomic<std::int64_t> m_pending{0};
+                std::mutex m_errorMutex;
+                std::exception_ptr m_error;
+        };
+    private:
+        // Lives on its waiter's stack, which may unwind as soon as done is seen, so
+        // nothing may touch the job after the release store. A waiter that sleeps
+        // passes a long-lived word to bump and wake instead (join() never sleeps)
+        template<typename F>
+        struct StackJob final : Job {
+            explicit StackJob(F f, std::atomic<std::uint32_t>* wakeWord = nullptr)
+                : fn(std::forward<F>(f)), wake(wakeWord) {}
+            void execute() override {
+                try {
+                    fn();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                auto* word = wake;
+                done.store(true, std::memory_order_release);
+                if (word) {
+                    word->fetch_add(1, std::memory_order_release);
+                    futex::wake(*word, INT_MAX);
+                }
+            }
+            F fn;
+            std::atomic<std::uint32_t>* const wake;
+            std::exception_ptr error;
+            std::atomic<bool> done{false};
+        };
+        struct alignas(64) Worker {
+            ChaseLevDeque deque;
+            std::minstd_rand rng;
+        };
+
+        template<typename F>
+        void runRoot(F&& f) {
+            StackJob<F&> root(f, &m_rootDone);
+            {
+                std::lock_guard lock(m_injectMutex);
+                m_injected.push_back(&root);
+                m_injectedCount.store(m_injected.size(), std::memory_order_relaxed);
+            }
+            notify();
+            // Read the word before checking done: a completion after this load changes it
+            for (auto seen = m_rootDone.load(std::memory_order_acquire); !root.done.load(std::memory_order_acquire);
+                 seen = m_rootDone.load(std::memory_order_acquire)) {
+                futex::wait(m_rootDone, seen);
+            }
+            if (root.error) std::rethrow_exception(root.error);
+        }
+        Job* takeInjected() {
+            if (m_injectedCount.load(std::memory_order_relaxed) == 0) return nullptr;
+            std::lock_guard lock(m_injectMutex);
+            if (m_injected.empty()) return nullptr;
+            Job* job = m_injected.back();
+            m_injected.pop_back();
+            m_injectedCount.store(m_injected.size(), std::memory_order_relaxed);
+            return job;
+        }
+        Job* stealOne(std::size_t self) {
+            const auto n = m_workers.size();
+            const auto start = m_workers[self].rng() % n;
+            for (std::size_t k = 0; k < n; ++k) {
+                const auto victim = (start + k) % n;
+                if (victim == self) continue;
+                if (Job* job = m_workers[victim].deque.steal()) return job;
+            }
+            return takeInjected();
+        }
+        Job* findWork(std::size_t self) {
+            if (Job* job = m_workers[self].deque.pop()) return job;
+            return stealOne(self);
+        }
+        // Runs other jobs until done() holds; used by join and sync
+        template<typename Done>
+        void helpUntil(Done done) {
+            while (!done()) {
+                if (Job* job = findWork(t_index)) {
+                    job->execute();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        bool hasWork() const {
+            if (m_injectedCount.load(std::memory_order_relaxed) != 0) return true;
+            for (const auto& worker : m_workers) {
+                if (!worker.deque.looks_empty()) return true;
+            }
+            return false;
+        }
+        // Dekker pairing with the sleeper: publish the work, fence, then look for
+        // sleepers; the sleeper registers, fences, then looks for work
+        void notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleepers.load(std::memory_order_relaxed) != 0) {
+                m_epoch.fetch_add(1, std::memory_order_release);
+                futex::wake(m_epoch, 1);
+            }
+        }
+        void workerLoop(std::size_t index) {
+            t_scheduler = this;
+            t_index = index;
+            int idle = 0;
+            while (!m_stop.load(std::memory_order_relaxed)) {
+                if (Job* job = findWork(index)) {
+                    job->execute();
+                    idle = 0;
+                    continue;
+                }
+                if (++idle < 64) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const auto epoch = m_epoch.load(std::memory_order_acquire);
+                m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!hasWork() && !m_stop.load(std::memory_order_relaxed)) {
+                    futex::wait(m_epoch, epoch);
+                }
+                m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                idle = 0;
+            }
+        }
+
+        inline static thread_local WorkStealingScheduler* t_scheduler = nullptr;
+        inline static thread_local std::size_t t_index = 0;
+        std::vector<Worker> m_workers;
+        std::mutex m_injectMutex;
+        std::vector<Job*> m_injected;
+        std::atomic<std::size_t> m_injectedCount{0};
+        alignas(64) std::atomic<std::uint32_t> m_epoch{0};
+        std::atomic<std::uint32_t> m_rootDone{0};   // bumped when a run() root job completes
+        alignas(64) std::atomic<std::uint32_t> m_sleepers{0};
+        std::atomic<bool> m_stop{false};
+        std::vector<std::thread> m_threads;
+};
+
+using TaskGroup = WorkStealingScheduler::TaskGroup;
+
+// Recursive splitting: halves the range until it is below the grain size
+long parallel_sum(const int* first, const int* last, std::size_t grain = 16 * 1024) {
+    if (static_cast<std::size_t>(last - first) <= grain) {
+        return std::accumulate(first, last, 0L);
+    }
+    const int* mid = first + (last - first) / 2;
+    long left = 0, right = 0;
+    WorkStealingScheduler::join([&] { left = parallel_sum(first, mid, grain); },
+                                [&] { right = parallel_sum(mid, last, grain); });
+    return left + right;
+}
+
+void parallel_quicksort(int* first, int* last) {
+    if (last - first <= 4096) {
+        std::sort(first, last);
+        return;
+    }
+    const int pivot = *std::next(first, (last - first) / 2);
+    int* mid1 = std::partition(first, last, [pivot](int x) { return x < pivot; });
+    int* mid2 = std::partition(mid1, last, [pivot](int x) { return !(pivot < x); });
+    TaskGroup group;
+    group.spawn([first, mid1] { parallel_quicksort(first, mid1); });
+    group.spawn([mid2, last] { parallel_quicksort(mid2, last); });
+    group.sync();
+}
+
+long fib(int n) {
+    if (n < 2) return n;
+    long a = 0, b = 0;
+    WorkStealingScheduler::join([&] { a = fib(n - 1); }, [&] { b = fib(n - 2); });
+    return a + b;
+}
+long serial_fib(int n) {
+    return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+long computeSum(const std::vector<int>& data, size_t start, size_t end) {
+    return std::accumulate(data.begin() + start, data.begin() + end, 0L);
+}
+
+template<typename F>
+double ms(F f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(1, 100);
+    std::vector<int> data(1 << 25);
+    for (auto& num : data) num = dist(rng);
+
+    std::vector<int> unsorted(5'000'000);
+    std::uniform_int_distribution<int> any(0, 1 << 30);
+    for (auto& num : unsorted) num = any(rng);
+    constexpr int fibN = 30;
+
+    // Baselines
+    long serialSum = 0, fourWaySum = 0, fibResult = 0;
+    const double sumSerial = ms([&] { serialSum = computeSum(data, 0, data.size()); });
+    const double sumFourWay = ms([&] {
+        const size_t partSize = data.size() / 4;
+        auto sum1 = std::async(std::launch::async, computeSum, std::cref(data), 0, partSize);
+        auto sum2 = std::async(std::launch::async, computeSum, std::cref(data), partSize, 2 * partSize);
+        auto sum3 = std::async(std::launch::async, computeSum, std::cref(data), 2 * partSize, 3 * partSize);
+        auto sum4 = std::async(std::launch::async, computeSum, std::cref(data), 3 * partSize, data.size());
+        fourWaySum = sum1.get() + sum2.get() + sum3.get() + sum4.get();
+    });
+    double sortSerial;
+    {
+        auto copy = unsorted;
+        sortSerial = ms([&] { std::sort(copy.begin(), copy.end()); });
+    }
+    const double fibSerial = ms([&] { fibResult = serial_fib(fibN); });
+    std::cout << "Total Sum: " << serialSum << " (four-way std::async: " << fourWaySum << ")" << std::endl;
+    std::cout << "serial: sum " << sumSerial << " ms, four-way std::async sum " << sumFourWay
+              << " ms, std::sort " << sortSerial << " ms, fib(" << fibN << ") " << fibSerial << " ms" << std::endl;
+
+    std::cout << "workers | sum ms (speedup) | quicksort ms (speedup) | fib ms (speedup)" << std::endl;
+    const std::size_t maxWorkers = std::max(4u, std::thread::hardware_concurrency());
+    for (std::size_t workers = 1; workers <= maxWorkers; workers *= 2) {
+        WorkStealingScheduler scheduler(workers);
+        long sum = 0, f = 0;
+        const double sumMs = ms([&] { sum = scheduler.run([&] { return parallel_sum(data.data(), data.data() + data.size()); }); });
+        auto copy = unsorted;
+        const double sortMs = ms([&] { scheduler.run([&] { parallel_quicksort(copy.data(), copy.data() + copy.size()); }); });
+        const double fibMs = ms([&] { f = scheduler.run([] { return fib(fibN); }); });
+        if (sum != serialSum || f != fibResult || !std::is_sorted(copy.begin(), copy.end())) {
+            std::cout << "wrong result!" << std::endl;
+        }
+        std::cout << workers << " | " << sumMs << " (" << sumSerial / sumMs << ")"
+                  << " | " << sortMs << " (" << sortSerial / sortMs << ")"
+                  << " | " << fibMs << " (" << fibSerial / fibMs << ")" << std::endl;
+    }
+    return 0;
+}
+/*------------- Output (1 core sandbox) -----------------------
+Total Sum: 1694642952 (four-way std::async: 1694642952)
+serial: sum 31.2926 ms, four-way std::async sum 32.9269 ms, std::sort 523.026 ms, fib(30) 2.72836 ms
+workers | sum ms (speedup) | quicksort ms (speedup) | fib ms (speedup)
+1 | 31.9851 (0.978348) | 577.228 (0.906099) | 36.7411 (0.074259)
+2 | 34.1286 (0.916902) | 594.349 (0.879997) | 37.6019 (0.0725589)
+4 | 32.3641 (0.966891) | 620.008 (0.843579) | 38.9974 (0.0699626)
+With one core no speedup is possible; the table shows the cost of the scheduler
+itself. Sum and quicksort stay within 10-15% of serial code at any worker count,
+so extra idle workers cost little. fib(30) without a cutoff does 1.3 million joins
+at about 27 ns each, against a serial fib that the compiler turns into a tight loop.
+Real recursive code stops splitting below a grain size, as parallel_sum does.
+-------------------------------------------------------------*/